@@ -1,453 +1,6920 @@
-#include <GLFW/glfw3.h>
-#include <Windows.h>
-#include <iostream>
-#include <thread>
-#include <vector>
-#include <complex>
-#include <mutex>
-#include <atomic>
-#include <chrono>
-#include <exception>
-
-using std::chrono::duration_cast;
-using std::chrono::milliseconds;
-using std::cout;
-using std::endl;
-using std::cin;
-using std::thread;
-using std::vector;
-using std::complex;
-using std::mutex;
-using std::unique_lock;
-using std::atomic_bool;
-using std::atomic_int;
-using std::condition_variable;
-using std::exception;
-
-// clock for performance measures
-typedef std::chrono::steady_clock timer;
-
-/*** ~ STRUCTS ~ ***/
-
-/* Contains Red, Green, and Blue, color values.
-Intended to represent the color of a pixel within the window */
-struct MclPixel
-{
-	float colour[3] = { 0, 0, 0 };
-	MclPixel(float _r, float _g, float _b)
-	{
-		colour[0] = _r;
-		colour[1] = _g;
-		colour[2] = _b;
-	}
-	MclPixel() {}
-};
-
-/* Contains two double values which are intended to
-represent x and y positions on the complex number plane */
-struct MclPoint
-{
-	double x = 0.0, y = 0.0;
-	MclPoint(double _x, double _y)
-	{
-		x = _x;
-		y = _y;
-	}
-	MclPoint(){}
-};
-
-/*** ~ GLOBAL CONSTANTS ~ ***/
-
-// Size of the window
-#define WINDOW_WIDTH 960
-#define WINDOW_HEIGHT 600
-
-// maximum number of threads to calculate mandelbrot (30 is overkill)
-#define MAX_THREADS 30
-
-// When the mandlebrot function reaches this many iterations, it is considered stable (does not go to infinity)
-#define MAX_ITERATIONS 500 
-
-// Scale of the cursor zoom box
-#define CURSOR_BOX_SCALE 0.01
-
-// Width and Height of the cursor zoom box. Dependant on the window size and scale of the cursor box
-const double CURSOR_BOX_WIDTH = WINDOW_WIDTH * CURSOR_BOX_SCALE, CURSOR_BOX_HEIGHT = WINDOW_HEIGHT * CURSOR_BOX_SCALE;
-
-// color of the cursor box
-const float colour[] = { 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0 };
-
-/*** ~ GLOBAL VARIABLES ~ ***/
-
-// position values of the box to draw around the cursor, used for zoom functionality also
-double cursorBox[8];
-
-// number of threads to compute mandlebrot set
-atomic_int threadCount = 1;
-
-// mutex to protect the 'threadCount' variable
-mutex threadCountMutex;
-
-// list of threads to compute mandlebrot set
-vector<thread> threadList;
-
-// current mandlebrot zoom values
-long double left, right, top, bottom;
-
-// 2D array of pixels which fill the window
-MclPixel pixels[WINDOW_WIDTH][WINDOW_HEIGHT];
-
-// size of each slice depending on number of threads
-int slice = 0;
-
-// mutexes to protect each "slice" (tile)
-mutex sliceMutexArray[MAX_THREADS];
-
-// used for pausing the main thread loop (signaling)
-mutex m;
-condition_variable pauseMandelbrotLoop;
-
-// should the mandelbrot set be recacalculated?
-atomic_bool recalculate = true;
-
-// has the GLFW window been closed?
-atomic_bool windowClosed = false;
-
-/*** ~ FUNCTIONS ~ ***/
-
-/* compute the mandlebrot set given zoom values and "slice" of the screen.
-Store pixel data to a global array. If 'running = false' computation will stop */
-void computeMandelbrot(int _threadTileId, long double _left, long double _right, long double _top, long double _bottom, int _startY, int _endY)
-{
-	try
-	{
-		for (int y = _startY; y < _endY; ++y)
-		{
-			if (recalculate) return;
-
-			for (int x = 0; x < WINDOW_WIDTH; ++x)
-			{
-				if (recalculate) return;
-
-				complex<long double> c(_left + (x * (_right - _left) / WINDOW_WIDTH), _top + (y * (_bottom - _top) / WINDOW_HEIGHT));
-				complex<long double> z(0.0, 0.0);
-
-				int iterations = 0;
-				while (abs(z) < 2.0 && iterations < MAX_ITERATIONS)
-				{
-					z = (z * z) + c;
-					++iterations;
-				}
-
-				float r = 1.0f, g = 1.0f, b = 1.0f;
-				if (iterations < MAX_ITERATIONS)
-				{
-					float q = ((float)(iterations)) / MAX_ITERATIONS;
-					r = q;
-					g = 0;
-					b = q;
-				}
-
-				sliceMutexArray[_threadTileId].lock();
-				pixels[x][y] = MclPixel(r, g, b);
-				sliceMutexArray[_threadTileId].unlock();
-			}
-		}
-	}
-	catch (const exception& e) { cout << "ERROR (computeMandelbrot)\n" << e.what() << endl; }
-}
-
-/* Converts a position on the screen into a position on the complex number plane */
-MclPoint getValueOfPixel(int _x, int _y)
-{
-	return MclPoint(left + (_x * (right - left) / WINDOW_WIDTH), top + (_y * (bottom - top) / WINDOW_HEIGHT));
-}
-
-/* Gets id of the "slice" (tile) which contains the row of pixels _y */
-int getTileId(int _y)
-{
-	return _y / slice;
-}
-
-/* Clears all pixels in the window */
-void clearPixels()
-{
-	for (int y = 0; y < WINDOW_HEIGHT; y++)
-	{
-		for (int x = 0; x < WINDOW_WIDTH; x++) pixels[x][y] = MclPixel();
-	}
-}
-
-/* signal main thread loop to recalculate mandelbrot */
-void signalRecalculation()
-{
-	try
-	{
-		recalculate = true;
-		pauseMandelbrotLoop.notify_one();
-	}
-	catch (const exception& e) { cout << "ERROR (signalRecalculation)\n" << e.what() << endl; }
-}
-
-/* sets the number of threads to compute mandelbrot */
-bool setThreadCount(int _newThreadCount)
-{
-	bool valid = false;
-	try
-	{
-
-		if (_newThreadCount < 1)
-		{
-			cout << "Cannot have less than 1 thread." << endl;
-		}
-		else if (_newThreadCount > MAX_THREADS)
-		{
-			cout << "Cannot have more than than " << MAX_THREADS << " threads." << endl;
-		}
-		else
-		{
-			threadCountMutex.lock();
-			threadCount.store(_newThreadCount);
-			slice = WINDOW_HEIGHT / threadCount;
-			threadCountMutex.unlock();
-			signalRecalculation();
-			cout << "Using " << _newThreadCount << " threads." << endl;
-			valid = true;
-		}
-	}
-	catch (const exception& e) { cout << "ERROR (setThreadCount)\n" << e.what() << endl; }
-	return valid;
-}
-
-int getThreadCount()
-{
-	int $return;
-	threadCountMutex.lock();
-	$return = threadCount.load();
-	threadCountMutex.unlock();
-	return $return;
-}
-
-/* Sets global zoom values and signals main thread to re-compute mandelbrot */
-void setZoom(long double _left, long double _right, long double _top, long double _bottom)
-{
-	left = _left;
-	right = _right;
-	top = _top;
-	bottom = _bottom;
-	signalRecalculation();
-}
-
-/* Sets the zoom values to display the whole mandelbrot set */
-void resetZoom()
-{
-	setZoom(-2.0, 1.0, 1.125, -1.125);
-}
-
-/*** ~ CALLBACK FUNCTIONS ~ ***/
-
-/*  Called when the cursor is moved. Stores the cursor position into global variables. */
-void cursorPositionCallback(GLFWwindow* _window, double _x, double _y)
-{
-	cursorBox[0] = _x - CURSOR_BOX_WIDTH;
-	cursorBox[1] = _y - CURSOR_BOX_HEIGHT;
-
-	cursorBox[2] = _x + CURSOR_BOX_WIDTH;
-	cursorBox[3] = _y - CURSOR_BOX_HEIGHT;
-
-	cursorBox[4] = _x + CURSOR_BOX_WIDTH;
-	cursorBox[5] = _y + CURSOR_BOX_HEIGHT;
-
-	cursorBox[6] = _x - CURSOR_BOX_WIDTH;
-	cursorBox[7] = _y + CURSOR_BOX_HEIGHT;
-}
-
-/* Called when the mouse is clicked. If left click, zoom in. If right click, zoom out to the default view */
-void mouseClickCallback(GLFWwindow* _window, int _butt, int _action, int _mods)
-{
-	try
-	{
-		if (_butt == GLFW_MOUSE_BUTTON_LEFT && _action == GLFW_RELEASE)
-		{
-			double zoomBoxSize = 10;
-			MclPoint TopLeft = getValueOfPixel(cursorBox[0], cursorBox[1]);
-			MclPoint BottomRight = getValueOfPixel(cursorBox[4], cursorBox[5]);
-			setZoom(TopLeft.x, BottomRight.x, TopLeft.y, BottomRight.y);
-		}
-		else if (_butt == GLFW_MOUSE_BUTTON_RIGHT && _action == GLFW_RELEASE) resetZoom();
-	}
-	catch (const exception& e) { cout << "ERROR (mouseClickCallback)\n" << e.what() << endl; }
-}
-
-void keypressCallback(GLFWwindow* _window, int _key, int _scancode, int _action, int _mods)
-{
-	if (_key == GLFW_KEY_UP && _action == GLFW_RELEASE)	setThreadCount(getThreadCount() + 1);
-	else if (_key == GLFW_KEY_DOWN && _action == GLFW_RELEASE) setThreadCount(getThreadCount() - 1);
-}
-
-/*** ~~~ ***/
-
-/* main rendering thread function. Handles GLFW setup calls and main rendering loop */
-void render()
-{
-	// GLFW setup
-	GLFWwindow* window;
-	try
-	{
-		if (!glfwInit()) return;
-		window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Mandelbrot", NULL, NULL);
-		glfwSetCursorPosCallback(window, cursorPositionCallback);
-		glfwSetMouseButtonCallback(window, mouseClickCallback);
-		glfwSetKeyCallback(window, keypressCallback);
-		if (!window) { glfwTerminate(); return; }
-		glfwMakeContextCurrent(window);
-		glViewport(0.0f, 0.0f, WINDOW_WIDTH, WINDOW_HEIGHT);
-		glMatrixMode(GL_PROJECTION);
-		glLoadIdentity();
-		glOrtho(0, WINDOW_WIDTH, WINDOW_HEIGHT, 0, 0, 1);
-		glMatrixMode(GL_MODELVIEW);
-		glLoadIdentity();
-	}
-	catch (const exception& e) { cout << "ERROR (GLFW setup)\n" << e.what() << endl; }
-
-	// create list of pixel locations on the screen for GLFW to assign colors
-	vector<int> pixelsToRender;
-	for (int y = 0; y < WINDOW_HEIGHT; y++)
-	{
-		for (int x = 0; x < WINDOW_WIDTH; x++)
-		{
-			pixelsToRender.push_back(x);
-			pixelsToRender.push_back(y);
-		}
-	}
-	const int TOTAL_VERTICIES = pixelsToRender.size() / 2;
-
-	// Main render loop
-	try
-	{
-		while (!glfwWindowShouldClose(window))
-		{
-			glClear(GL_COLOR_BUFFER_BIT);
-
-			// Render pixels (Mandlebrot)
-			glEnableClientState(GL_VERTEX_ARRAY);
-			glEnableClientState(GL_COLOR_ARRAY);
-			glPointSize(1);
-			glVertexPointer(2, GL_INT, 0, pixelsToRender.data());
-
-			// get color values from global array
-			vector<float> pixelColors;
-			for (int y = 0; y < WINDOW_HEIGHT; y++)
-			{
-				int tileID = getTileId(y);
-				sliceMutexArray[tileID].lock(); // lock the mutex for each horizontal row of pixels 
-				for (int x = 0; x < WINDOW_WIDTH; x++)
-				{
-					float* tmp = pixels[x][y].colour;
-					pixelColors.push_back(tmp[0]);
-					pixelColors.push_back(tmp[1]);
-					pixelColors.push_back(tmp[2]);
-
-				}
-				sliceMutexArray[tileID].unlock();
-			}
-
-			glColorPointer(3, GL_FLOAT, 0, pixelColors.data());
-			glDrawArrays(GL_POINTS, 0, TOTAL_VERTICIES);
-			glDisableClientState(GL_COLOR_ARRAY);
-			glDisableClientState(GL_VERTEX_ARRAY);
-
-			// Render the cursor box
-			glEnableClientState(GL_VERTEX_ARRAY);
-			glEnableClientState(GL_COLOR_ARRAY);
-			glVertexPointer(2, GL_DOUBLE, 0, cursorBox);
-			glColorPointer(3, GL_FLOAT, 0, colour);
-			glDrawArrays(GL_LINE_LOOP, 0, 4);
-			glDisableClientState(GL_COLOR_ARRAY);
-			glDisableClientState(GL_VERTEX_ARRAY);
-
-			glfwSwapBuffers(window);
-			glfwPollEvents();
-		}
-	}
-	catch (const exception& e) { cout << "ERROR (GLFW rendering loop)\n" << e.what() << endl; }
-
-	windowClosed = true;
-	recalculate = true;
-
-	glfwTerminate();
-}
-
-/*** ~ MAIN FUNCTION ~ ***/
-int main()
-{
-	try
-	{
-		// get # of threads from the user, validate input
-		{
-			int localThreadCount = -1;
-			do
-			{
-				cout << "Enter number of threads: ";
-				cin >> localThreadCount;
-			} while (!setThreadCount(localThreadCount));
-		}
-
-		// display some information
-		cout << "Please wait...\n" << endl;
-		cout << "Left Click - Zoom in.\nRight Click - Reset zoom.\nUp Key - Increase threads by one.\nDown Key - Decrease threads by one." << endl;
-		cout << "\n\nPERFORMANCE MEASUREMENTS:" << endl;
-
-		// set zoom values to default
-		resetZoom();
-
-		// start rendering thread
-		thread renderingThread(render);
-
-		// mandelbrot calculation loop
-		try
-		{
-			while (!windowClosed)
-			{
-				clearPixels();
-				recalculate = false;
-
-				// start timer
-				timer::time_point start = timer::now();
-
-				// start mandelbrot threads
-				int tmpLocalThreadCount = getThreadCount();
-				for (int i = 0; i < tmpLocalThreadCount; i++)
-				{
-					int startY = i * slice;
-					threadList.push_back(thread(computeMandelbrot, i, left, right, top, bottom, startY, startY + slice));
-				}
-
-				// join mandelbrot threads
-				for (int i = 0; i < threadList.size(); i++)
-				{
-					if (threadList[i].joinable()) threadList[i].join();
-				}
-				threadList.clear();
-
-				// end timer and
-				timer::time_point end = timer::now();
-				int time_taken = duration_cast<milliseconds>(end - start).count();
-				if (!recalculate)
-				{
-					cout << time_taken << "ms" << endl; // display computation time
-					{ unique_lock<mutex> lk(m); pauseMandelbrotLoop.wait(lk); } // pause and wait
-				}
-			}
-		}
-		catch (const exception& e) { cout << "ERROR (mandelbrot calculation loop)\n" << e.what() << endl; }
-
-		renderingThread.join();
-
-		cout << "\n\nDone.\n\n" << endl;
-		system("pause");
-	}
-	catch (const exception& e) { cout << "ERROR (main)\n" << e.what() << endl; }
-
-	return 0;
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <GLFW/glfw3.h>
+#include <Windows.h>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <limits>
+#include <type_traits>
+#include <new>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#pragma comment(lib, "ws2_32.lib")
+#endif
+
+// OpenGL 2.0 / 3.0 constants used by the GPU backend, missing from the OpenGL 1.1 header on Windows
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+#ifndef GL_FRAGMENT_SHADER
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#endif
+#ifndef GL_FRAMEBUFFER
+#define GL_FRAMEBUFFER 0x8D40
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#endif
+
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::microseconds;
+using std::cout;
+using std::endl;
+using std::cin;
+using std::thread;
+using std::vector;
+using std::deque;
+using std::mutex;
+using std::unique_lock;
+using std::atomic_bool;
+using std::atomic_int;
+using std::condition_variable;
+using std::exception;
+using std::shared_ptr;
+using std::make_shared;
+
+// clock for performance measures
+typedef std::chrono::steady_clock timer;
+
+/*** ~ STRUCTS ~ ***/
+
+/* Contains Red, Green, Blue, and Alpha color values, 8 bits each in the layout of an RGBA8 texture.
+Intended to represent the color of a pixel within the window */
+struct MclPixel
+{
+	uint8_t colour[4] = { 0, 0, 0, 255 };
+	MclPixel(float _r, float _g, float _b)
+	{
+		colour[0] = (uint8_t)(_r * 255.0f + 0.5f);
+		colour[1] = (uint8_t)(_g * 255.0f + 0.5f);
+		colour[2] = (uint8_t)(_b * 255.0f + 0.5f);
+	}
+	MclPixel() {}
+};
+
+// size in bytes of a cache line, rows of an 'MclBuffer' start on one
+#define CACHE_LINE_SIZE 64
+
+/* Row-major buffer of one value per pixel, e.g. the iteration count of each pixel, the raw result of the kernels.
+Each row is padded to a whole number of cache lines and the storage is cache line aligned, so
+neighbouring pixels of a row share cache lines and rows written by different workers do not.
+Colour is worked out from it in a separate pass, so a different colouring needs no recomputation */
+template <typename T>
+struct MclBuffer
+{
+	int width = 0, height = 0;
+	int stride = 0; // distance in elements between the start of two rows
+	size_t capacity = 0; // number of elements allocated, the storage is only reallocated when a resize needs more
+	T* values = nullptr;
+	MclBuffer(int _width, int _height) { resize(_width, _height); }
+	~MclBuffer() { ::operator delete(values, std::align_val_t(CACHE_LINE_SIZE)); }
+	MclBuffer(const MclBuffer&) = delete;
+	MclBuffer& operator=(const MclBuffer&) = delete;
+	void resize(int _width, int _height) // clears the buffer, unless the size is unchanged
+	{
+		if (reshape(_width, _height)) clear();
+	}
+	bool reshape(int _width, int _height) // like 'resize', but leaves the values to the caller. Returns false if the size is unchanged
+	{
+		if (values && _width == width && _height == height) return false;
+		const int ROW_ALIGNMENT = CACHE_LINE_SIZE / sizeof(T) > 0 ? CACHE_LINE_SIZE / sizeof(T) : 1;
+		width = _width;
+		height = _height;
+		stride = (_width + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT;
+		if ((size_t)stride * height > capacity || !values)
+		{
+			::operator delete(values, std::align_val_t(CACHE_LINE_SIZE));
+			capacity = (size_t)stride * height;
+			values = (T*)::operator new(sizeof(T) * std::max<size_t>(capacity, 1), std::align_val_t(CACHE_LINE_SIZE));
+		}
+		return true;
+	}
+	T* row(int _y) { return values + (size_t)_y * stride; }
+	const T* row(int _y) const { return values + (size_t)_y * stride; }
+	void release() { ::operator delete(values, std::align_val_t(CACHE_LINE_SIZE)); values = nullptr; capacity = 0; width = height = 0; } // the next resize allocates it afresh
+	void clear() { clearRows(0, height); }
+	void clearRows(int _startY, int _endY) { memset((void*)row(_startY), 0, sizeof(T) * stride * (_endY - _startY)); }
+	void copyFrom(const MclBuffer& _other) { resize(_other.width, _other.height); memcpy((void*)values, _other.values, sizeof(T) * stride * height); }
+};
+
+// Iteration counts of a frame
+typedef MclBuffer<uint32_t> MclIterationBuffer;
+
+/* A double-double number, the unevaluated sum of two doubles with |lo| <= ulp(hi) / 2.
+Gives about 106 bits of mantissa for deep zooms, see the DOUBLE-DOUBLE ARITHMETIC section */
+struct MclDoubleDouble
+{
+	double hi = 0.0, lo = 0.0;
+	MclDoubleDouble(double _hi, double _lo)
+	{
+		hi = _hi;
+		lo = _lo;
+	}
+	MclDoubleDouble(double _value)
+	{
+		hi = _value;
+	}
+	MclDoubleDouble() {}
+};
+
+// Number of 32 bit limbs in a MclBigFixed, 1 for the integer part and the rest for the fraction.
+// 40 limbs hold 1248 fraction bits, more than the exponent range of the doubles used for the pixel size
+#define BIGFIXED_LIMBS 40
+
+/* Arbitrary precision signed fixed point number, in two's complement. limb[0] is the integer part and
+limb[1..] are the fraction, most significant first. See the BIG FIXED POINT ARITHMETIC section */
+struct MclBigFixed
+{
+	uint32_t limb[BIGFIXED_LIMBS] = {};
+	MclBigFixed(double _value)
+	{
+		// every step is exact: scaling by 2^32, floor, and subtracting the whole part
+		double x = fabs(_value);
+		for (int i = 0; i < BIGFIXED_LIMBS && x != 0.0; i++)
+		{
+			double whole = floor(x);
+			limb[i] = (uint32_t)whole;
+			x = (x - whole) * 4294967296.0;
+		}
+		if (_value < 0.0)
+		{
+			uint64_t carry = 1;
+			for (int i = BIGFIXED_LIMBS - 1; i >= 0; i--)
+			{
+				carry += (uint32_t)~limb[i];
+				limb[i] = (uint32_t)carry;
+				carry >>= 32;
+			}
+		}
+	}
+	MclBigFixed() {}
+};
+
+/* Contains two arbitrary precision values which are intended to
+represent x and y positions on the complex number plane */
+struct MclPoint
+{
+	MclBigFixed x, y;
+	MclPoint(MclBigFixed _x, MclBigFixed _y)
+	{
+		x = _x;
+		y = _y;
+	}
+	MclPoint(){}
+};
+
+/* The orbit of one reference point for the perturbation kernel, computed in arbitrary precision and stored as doubles.
+Contains Z_0 up to the first Z_n which escapes (or Z_n at the iteration limit) */
+struct MclReferenceOrbit
+{
+	double px = 0.0, py = 0.0; // position of the reference point in pixels
+	vector<double> zr, zi;
+	vector<double> glitchLimit; // a pixel is glitched at step n if |z_n|^2 drops below this
+};
+
+/* Reference orbits for one frame of the perturbation kernel. The primary reference is at the centre of the view,
+extra references are added by the workers as they find glitched pixels */
+struct MclReferenceSet
+{
+	int limbs = BIGFIXED_LIMBS; // MclBigFixed limbs needed for the zoom depth of the frame
+	shared_ptr<MclReferenceOrbit> primary;
+	vector<shared_ptr<MclReferenceOrbit>> secondary;
+	mutex secondaryMutex;
+};
+
+/* Formulas the kernels iterate, see 'stepFormula' */
+enum MclFormula
+{
+	FORMULA_MANDELBROT, // z = z^p + c from z = 0, c is the point. Powers above 2 give the Multibrot sets
+	FORMULA_JULIA, // z = z^p + c for a fixed c, z starts at the point
+	FORMULA_BURNING_SHIP, // z = (|Re z| + i |Im z|)^p + c from z = 0, c is the point
+	FORMULA_COUNT
+};
+
+/* The fractal a view shows. Each formula and power has kernels of its own, see 'dispatchFractal' */
+struct MclFractal
+{
+	int formula = FORMULA_MANDELBROT;
+	int power = 2; // from 2 to MAX_POWER
+	double juliaR = 0.0, juliaI = 0.0; // the fixed c of FORMULA_JULIA, 0 for the other formulas
+};
+
+/* The part of the complex number plane shown in the window, pixel (x, y) is at (left + x * pixelWidth, top + y * pixelHeight).
+The top left corner is stored in arbitrary precision, and rounded to double-double for the kernels. The view of a frame
+has the render resolution, which can differ from the window size (see 'getRenderView') */
+struct MclView
+{
+	MclBigFixed exactLeft, exactTop;
+	MclDoubleDouble left, top;
+	double pixelWidth = 0.0, pixelHeight = 0.0;
+	int width = 0, height = 0; // size in pixels
+	double scale = 1.0; // pixels per pixel of the window, see 'getRenderView'
+	shared_ptr<MclReferenceSet> references; // only set for frames computed by the perturbation kernel
+	MclFractal fractal;
+	bool interiorChecks = true; // skip the main bulbs and stop periodic orbits early (see 'kernelScalarImpl')
+	int maxIterations = 0; // iteration limit, points which have not escaped by then are considered stable
+	uint32_t generation = 0; // 'viewGeneration' the view was taken at, its jobs are dropped once that changes
+};
+
+/* Identifies the iteration counts of a tile exactly: the position of its top left pixel in full precision, its pixel size
+(the zoom level) and size, and everything else the counts depend on. Tiles of different views with the same key are identical */
+struct MclTileKey
+{
+	MclBigFixed left, top;
+	double pixelWidth = 0.0, pixelHeight = 0.0;
+	int width = 0, height = 0;
+	int maxIterations = 0;
+	int kernelIndex = 0;
+	bool interiorChecks = false;
+	MclFractal fractal;
+};
+
+/* Iteration counts and escape fractions of a tile kept by the tile cache, tightly packed rows */
+struct MclTileCacheEntry
+{
+	MclTileKey key;
+	uint64_t hash = 0;
+	vector<uint32_t> iterations;
+	vector<float> fractions;
+};
+
+/* Recently computed tiles kept in memory, most recently used first. Only used by the main thread, see the TILE CACHE section */
+struct MclTileCache
+{
+	std::list<MclTileCacheEntry> entries;
+	std::unordered_map<uint64_t, std::list<MclTileCacheEntry>::iterator> index; // by 'hashTileKey'
+	size_t bytes = 0;
+};
+
+/* Start of a slot of the tile store file, followed by room for the iteration counts and escape fractions of a whole tile.
+The slot of a tile is its hash modulo the number of slots, a new tile replaces the old one */
+struct MclTileStoreSlot
+{
+	uint64_t hash;
+	MclTileKey key; // width 0 while the slot is empty
+};
+
+/* Tiles kept on disk between sessions, in a memory mapped file of TILE_STORE_SLOTS slots after a header */
+struct MclTileStore
+{
+	HANDLE file = INVALID_HANDLE_VALUE, mapping = nullptr;
+	uint8_t* data = nullptr; // nullptr if the store could not be opened
+};
+
+/* Start of an iteration map file, which keeps the iteration counts and escape fractions of a whole batch render.
+It is followed by the tiles, each compressed on its own with 'encodeTile', in rows from the top left, then by the offset
+of every tile and of the end of the last one. See 'createIterationMap' and 'openIterationMap' */
+struct MclMapHeader
+{
+	char magic[16];
+	uint32_t layout[2]; // TILE_SIZE and BIGFIXED_LIMBS, the file is only read by builds with the same
+	int32_t width, height; // of the map in pixels
+	int32_t maxIterations;
+	int32_t precision; // of the kernel which computed the map
+	int32_t interiorChecks;
+	int32_t formula, power; // of the fractal, see 'MclFractal'
+	int32_t reserved;
+	double pixelWidth, pixelHeight;
+	double juliaR, juliaI;
+	MclBigFixed exactLeft, exactTop; // of the top left pixel
+	uint64_t indexOffset; // where the tile offsets start, 0 until the map is finished
+};
+
+/* An iteration map being written a few rows of tiles at a time, see the IMAGE OUTPUT section */
+struct MclMapWriter
+{
+	std::ofstream file;
+	MclMapHeader header;
+	uint64_t size = 0; // bytes written so far
+	vector<uint64_t> index; // offset of every tile written so far
+	int rowsWritten = 0;
+};
+
+/* An iteration map opened to fill frames from, memory mapped as it is. Tiles are only decoded when a frame needs them,
+into the tile cache. See 'findMapTile' */
+struct MclIterationMap
+{
+	HANDLE file = INVALID_HANDLE_VALUE, mapping = nullptr;
+	const uint8_t* data = nullptr; // nullptr if no map is open
+	const MclMapHeader* header = nullptr;
+	const uint64_t* index = nullptr; // offset of every tile of 'view', and of the end of the last one
+	MclView view; // the whole map
+};
+
+/* Where the orbit of a pixel stopped, so it can be continued when the iteration limit is raised */
+struct MclOrbitState
+{
+	double zr = 0.0, zi = 0.0;
+};
+
+/* Escape time kernel. Computes the number of iterations for '_count' pixels of the view,
+given as separate arrays of x and y positions in pixels. Each kernel converts the positions
+to the complex number plane in its own precision. Kernels up to double precision also store
+the last z of each pixel in '_orbits'. Their resume variants continue the orbits given in '_orbits' instead of
+starting at z = 0, all from the same iteration count '_iterations[0]', see 'resumeMandelbrot'.
+Returns the number of iterations run, including those of points later found to be interior */
+typedef long long (*MclKernel)(const MclView& _view, const double* _px, const double* _py, int _count, int* _iterations, MclOrbitState* _orbits);
+
+// number of pixels collected for one kernel call
+#define SAMPLE_BATCH_SIZE 32
+
+/* Pixels collected for one kernel call, with where in the back buffer each result goes */
+struct MclSampleBatch
+{
+	MclKernel kernel = nullptr;
+	const MclView* view = nullptr;
+	double px[SAMPLE_BATCH_SIZE], py[SAMPLE_BATCH_SIZE];
+	uint32_t* targets[SAMPLE_BATCH_SIZE];
+	int count = 0;
+	int resumeFrom = 0; // iteration count of the orbits the kernel continues from 'orbitPixels', 0 starts them at z = 0
+	int workerId = 0; // whose counters in 'workerStatsArray' the batch adds to
+	MclSampleBatch(MclKernel _kernel, const MclView& _view, int _workerId)
+	{
+		kernel = _kernel;
+		view = &_view;
+		workerId = _workerId;
+	}
+};
+
+/* Instruction set extensions a kernel can require */
+enum MclCpuFeature
+{
+	CPU_SCALAR,
+	CPU_AVX2,
+	CPU_AVX512
+};
+
+/* Floating point precision a kernel iterates in, from cheapest to most precise */
+enum MclPrecision
+{
+	PRECISION_FLOAT,
+	PRECISION_DOUBLE,
+	PRECISION_LONG_DOUBLE,
+	PRECISION_DOUBLE_DOUBLE,
+	PRECISION_PERTURBATION
+};
+
+/* Where the mandelbrot set is computed, chosen at startup */
+enum MclBackend
+{
+	BACKEND_CPU,
+	BACKEND_GPU_FLOAT,
+	BACKEND_GPU_DOUBLE
+};
+
+/* OpenGL 2.0 and framebuffer object entry points used by the GPU backend.
+opengl32 only exports OpenGL 1.1, so these are loaded at runtime from the rendering thread's context */
+struct MclGpuFunctions
+{
+	GLuint (APIENTRY* createShader)(GLenum) = nullptr;
+	void (APIENTRY* shaderSource)(GLuint, GLsizei, const char* const*, const GLint*) = nullptr;
+	void (APIENTRY* compileShader)(GLuint) = nullptr;
+	void (APIENTRY* getShaderiv)(GLuint, GLenum, GLint*) = nullptr;
+	void (APIENTRY* getShaderInfoLog)(GLuint, GLsizei, GLsizei*, char*) = nullptr;
+	void (APIENTRY* deleteShader)(GLuint) = nullptr;
+	GLuint (APIENTRY* createProgram)() = nullptr;
+	void (APIENTRY* attachShader)(GLuint, GLuint) = nullptr;
+	void (APIENTRY* linkProgram)(GLuint) = nullptr;
+	void (APIENTRY* getProgramiv)(GLuint, GLenum, GLint*) = nullptr;
+	void (APIENTRY* getProgramInfoLog)(GLuint, GLsizei, GLsizei*, char*) = nullptr;
+	void (APIENTRY* deleteProgram)(GLuint) = nullptr;
+	void (APIENTRY* useProgram)(GLuint) = nullptr;
+	GLint (APIENTRY* getUniformLocation)(GLuint, const char*) = nullptr;
+	void (APIENTRY* uniform1i)(GLint, GLint) = nullptr;
+	void (APIENTRY* uniform2f)(GLint, GLfloat, GLfloat) = nullptr;
+	void (APIENTRY* genFramebuffers)(GLsizei, GLuint*) = nullptr;
+	void (APIENTRY* bindFramebuffer)(GLenum, GLuint) = nullptr;
+	void (APIENTRY* framebufferTexture2D)(GLenum, GLenum, GLenum, GLuint, GLint) = nullptr;
+	GLenum (APIENTRY* checkFramebufferStatus)(GLenum) = nullptr;
+	void (APIENTRY* deleteFramebuffers)(GLsizei, const GLuint*) = nullptr;
+};
+
+/* State of the GPU backend, owned by the rendering thread. The shader renders straight into the display texture */
+struct MclGpuBackend
+{
+	MclGpuFunctions gl;
+	GLuint program = 0, framebuffer = 0;
+	GLint leftLocation = -1, topLocation = -1, pixelWidthLocation = -1, pixelHeightLocation = -1;
+	GLint maxIterationsLocation = -1, interiorChecksLocation = -1;
+	int nextTileRow = 0; // next row of tiles of the pending frame to run the shader over
+};
+
+/* The texture the window is drawn from, at the render resolution of the frame it holds */
+struct MclDisplayTexture
+{
+	GLuint id = 0;
+	int width = 0, height = 0;
+	double scale = 1.0; // pixels of the texture per pixel of the window
+};
+
+/* File formats the batch renderer can write */
+enum MclImageFormat
+{
+	IMAGE_PNG,
+	IMAGE_TIFF
+};
+
+/* An 8 bit RGB image file written a few rows at a time, so the whole image never has to be in memory.
+PNG is written as stored (uncompressed) deflate blocks, one IDAT chunk per call. TIFF is uncompressed, with
+the strip offsets laid out in the header in advance. See the IMAGE OUTPUT section */
+struct MclImageWriter
+{
+	std::ofstream file;
+	MclImageFormat format = IMAGE_PNG;
+	int width = 0, height = 0;
+	int rowsWritten = 0;
+	uint32_t adler = 1; // Adler-32 of the PNG image data so far, ends the zlib stream
+};
+
+/* Streams the frames of an animation can be written as */
+enum MclVideoFormat
+{
+	VIDEO_Y4M, // YUV4MPEG2, 4:4:4 chroma, readable by most encoders
+	VIDEO_RAW, // headerless 8 bit RGB frames, back to back
+	VIDEO_IMAGES // one PNG or TIFF file per frame, named by a printf pattern such as frame%05d.png
+};
+
+/* An animation being written one frame at a time, see the IMAGE OUTPUT section */
+struct MclVideoWriter
+{
+	std::ofstream file; // not used for image sequences
+	MclVideoFormat format = VIDEO_Y4M;
+	std::string path;
+	int width = 0, height = 0;
+	int framesWritten = 0;
+};
+
+/* Settings of a batch render, taken from the command line */
+struct MclBatchOptions
+{
+	MclBigFixed centreX = MclBigFixed(-0.5), centreY = MclBigFixed(0.0);
+	double zoom = 1.0; // 1 shows the default view's width of 3 across the image
+	int width = 1920, height = 1080;
+	int maxIterations = 0; // 0 uses the default limit, raised with the zoom like the L key does
+	int threads = 0; // 0 uses one per hardware thread, see 'getAutomaticThreadCount'
+	bool pin = false; // see 'threadPinning'
+	MclFractal fractal;
+	bool centreGiven = false; // if not, the centre is moved to the middle of 'fractal', see 'resetZoom'
+	std::string keyframes; // file with the keyframes of an animation, a single image is rendered without it
+	int frames = 0; // number of frames of an animation, 0 gives 'fps' frames per second of keyframe time
+	int fps = 30;
+	int palette = 0; // index into 'paletteArray'
+	bool smooth = true; // see 'smoothColouring'
+	std::string output; // defaults to mandelbrot.png, or mandelbrot.y4m for an animation
+	std::string bench; // report file of the benchmark suite (.csv or .json), see 'runBenchmark'
+	int repeats = 0; // timed runs of each benchmark, 0 uses BENCH_REPEATS
+	std::string farm; // worker processes to share the tiles with, "host:port,host:port", see 'startRenderFarm'
+	int servePort = 0; // if not 0, run as a worker process of a render farm on this port instead, see 'runFarmWorker'
+};
+
+/* Kinds of messages between the coordinator of a render farm and its worker processes, see the DISTRIBUTED RENDERING section */
+enum MclFarmMessage
+{
+	FARM_HELLO, // sent by both ends when they connect, the connection is dropped if they are not the same build
+	FARM_JOB, // a range of tiles of a frame to compute
+	FARM_TILES // the computed tiles of a job, compressed
+};
+
+/* Tiles of a frame handed out together, the tiles 'first' to 'first + count - 1' by id */
+struct MclTileRange
+{
+	uint32_t epoch = 0; // frame the tiles are of
+	int first = 0, count = 0;
+};
+
+/* A worker process the coordinator of a render farm shares the tiles of its frames with */
+struct MclFarmNode
+{
+	std::string host, port;
+	thread connection; // sends the node jobs and receives their tiles, see 'runFarmNode'
+	int threads = 1; // worker threads of the node, from its greeting
+	long long tiles = 0; // tiles it computed
+	int drops = 0; // connections lost, their jobs went back to the queue
+};
+
+/* The frame of a batch render whose tiles are shared with worker processes, see the DISTRIBUTED RENDERING section.
+The nodes take tiles off the front of the queue as they finish their last ones, so faster nodes get more of them */
+struct MclRenderFarm
+{
+	std::list<MclFarmNode> nodes;
+	thread local; // computes tiles on the worker pool of this process as one more node, see 'runLocalNode'
+	mutex lock; // protects everything below
+	condition_variable changed; // tiles were queued or received, or the farm shuts down
+	deque<MclTileRange> queue; // tiles of the frame nobody computes yet
+	MclView view;
+	int kernelIndex = 0;
+	int tilesLeft = 0; // tiles of the frame not received yet
+	long long localTiles = 0; // tiles computed by this process
+	bool shutdown = false;
+};
+
+/* A point on the path of a zoom animation, see 'getKeyframeOptions' */
+struct MclKeyframe
+{
+	double time = 0.0; // in seconds
+	MclBigFixed centreX, centreY;
+	double zoom = 1.0;
+};
+
+/* One view of the benchmark suite. The views are fixed, so that the reports of different builds can be compared */
+struct MclBenchView
+{
+	const char* name;
+	const char* centreX; // read with 'parseBigFixed', to keep every digit of deep views
+	const char* centreY;
+	double zoom;
+	int maxIterations;
+	bool interiorChecks;
+};
+
+/* Timing of one view of the benchmark suite with one kernel or GPU backend and thread count, see 'runBenchmark' */
+struct MclBenchResult
+{
+	std::string view, kernel;
+	int threads = 0; // 0 for the GPU backends
+	int maxIterations = 0;
+	double medianMs = 0.0, p95Ms = 0.0;
+	double iterations = 0.0; // iterations the kernels ran for one frame, see 'getFrameStats'
+	double efficiency = 1.0; // speedup over one thread, divided by the number of threads
+};
+
+/* Describes one of the palettes the colour pass can use, as evenly spaced colour stops which are blended into a lookup table */
+struct MclPaletteInfo
+{
+	const char* name;
+	bool cyclic; // repeat every PALETTE_CYCLE_ITERATIONS iterations, instead of stretching from 0 to the iteration limit
+	int stopCount;
+	float stops[8][3];
+	float interior[3]; // colour of the points inside the set
+};
+
+/* Everything the colour pass needs besides the pixels, taken from the colour settings for each frame. See 'getColouring' */
+struct MclColouring
+{
+	const MclPixel* palette = nullptr; // PALETTE_SIZE colours, followed by the interior colour
+	bool cyclic = false;
+	bool smooth = false; // add the fraction of an iteration at which each pixel escaped, see 'getEscapeFraction'
+	int maxIterations = 0;
+	const vector<float>* equalisation = nullptr; // with histogram equalisation, see 'getEqualisation'
+};
+
+/* Describes one of the available kernels */
+struct MclKernelInfo
+{
+	const char* name;
+	MclKernel function;
+	MclKernel resume; // variant continuing stored orbits, nullptr if the kernel cannot continue them
+	MclCpuFeature requires;
+	MclPrecision precision;
+};
+
+/* A unit of work for the worker pool. Describes one rectangular tile
+of the mandelbrot set to compute with the given zoom values */
+struct MclJob
+{
+	MclKernel kernel = nullptr;
+	MclView view;
+	uint32_t epoch = 0; // frame the job belongs to, see 'frameEpoch'
+	int startX = 0, endX = 0, startY = 0, endY = 0;
+	int step = 1; // pass of a progressive frame, only pixels whose coordinates are multiples of 'step' are computed
+	bool refine = false; // skip the pixels already computed by the previous, twice as coarse pass
+	bool subdivide = false; // compute with Mariani-Silver subdivision instead, see 'subdivideRectangle'
+	bool subRectangle = false; // part of a subdivided tile, whose border has been computed already
+	bool antialias = false; // give the edges of a finished tile extra samples instead, see 'antialiasTile'
+	int resumeFrom = 0; // iteration limit of the frame being continued, see 'resumeMandelbrot'. 0 computes the tile from scratch
+	int prefetchKernelIndex = -1; // kernel of a speculative job for the tile cache instead of the back buffer, see 'prefetchTile'
+	uint32_t hoverGeneration = 0; // 'hoverGeneration' a speculative job was made for, it is dropped once the cursor moves
+	MclJob(MclKernel _kernel, const MclView& _view, uint32_t _epoch, int _startX, int _endX, int _startY, int _endY)
+	{
+		kernel = _kernel;
+		view = _view;
+		epoch = _epoch;
+		startX = _startX;
+		endX = _endX;
+		startY = _startY;
+		endY = _endY;
+	}
+	MclJob() {}
+};
+
+/* Double ended queue of jobs owned by one worker. The owner takes jobs from
+the front, idle workers steal from the back */
+struct MclWorkerQueue
+{
+	deque<MclJob> jobs;
+	mutex jobsMutex;
+};
+
+/* A logical processor of the machine, see 'detectCpuTopology' */
+struct MclLogicalCpu
+{
+	int group = 0, number = 0; // processor group and number within it, as Windows addresses processors
+	int core = 0; // physical core it belongs to
+	int sibling = 0; // which of the hardware threads of its core it is
+	int node = 0; // NUMA node
+	int efficiency = 0; // efficiency class of its core, higher is faster. Only differs between the cores of a hybrid CPU
+};
+
+/* The processors of the machine, in the order pinned workers are placed on them: first one hardware thread of each
+of the fastest cores, spread evenly over the NUMA nodes, then of the slower cores, then the other hardware threads */
+struct MclCpuTopology
+{
+	vector<MclLogicalCpu> cpus;
+	int nodeCount = 1;
+	int coreCount = 0;
+	int fastCoreCount = 0; // cores of the highest efficiency class, the P-cores of a hybrid CPU
+	int fastestEfficiency = 0; // that efficiency class
+};
+
+/* Deals the tiles of a pass out to the queues of the active workers, see 'getTileDealer' */
+struct MclTileDealer
+{
+	int workerCount = 1;
+	int dealt = 0; // tiles dealt so far
+	vector<int> bandEnds; // first row past the band of the frame each NUMA node computes
+	vector<vector<int>> workers; // the workers pinned to each node, those on fast cores first. Empty if workers are not pinned
+	vector<int> fastWorkers; // how many of the workers of each node are on fast cores
+	vector<int> dealtTo; // tiles dealt to each node so far, [node * 3] of unknown cost, [node * 3 + 1] costly and [node * 3 + 2] cheap ones
+	double meanCost = 0.0; // mean time the tiles of the frame took so far, 0 if none took any or if all cores are as fast
+};
+
+/* One extra sample of an anti-aliased pixel, see 'antialiasTile' */
+struct MclAaSample
+{
+	uint16_t pixel = 0; // index of the pixel in its tile, row by row
+	uint32_t iterations = 0;
+	float fraction = 0.0f;
+};
+
+/* One job as recorded for a trace of the worker pool, see 'writeChromeTrace' */
+struct MclTraceEvent
+{
+	int workerId = 0; // -1 for a whole frame, timed by the main thread
+	int tileId = 0, step = 1;
+	long long start = 0, duration = 0; // in microseconds since 'sessionStart'
+};
+
+/* Counters of one worker for the frame it last worked on, summed up by 'getFrameStats'. A worker only writes its own,
+and each is aligned to a cache line, so workers counting at the same time do not take the line from each other */
+struct alignas(CACHE_LINE_SIZE) MclWorkerStats
+{
+	uint32_t epoch = 0; // frame the counters are of, they are cleared by the first job of the worker in a newer frame
+	long long busyMicroseconds = 0; // time spent computing jobs
+	long long iterations = 0; // iterations the kernels ran, see 'MclKernel'
+	long long escapedPixels = 0, limitPixels = 0, interiorPixels = 0; // pixels computed, by their result
+	long long filledPixels = 0; // pixels filled in by subdivision without being computed
+	long long antialiasedPixels = 0, extraSamples = 0; // edge pixels given extra samples, and how many they got
+	vector<MclTraceEvent> trace; // jobs finished while 'traceRecording' is on, kept until 'collectTrace' takes them
+};
+
+/*** ~ DOUBLE-DOUBLE ARITHMETIC ~ ***/
+
+// Error free transformations from Dekker and Knuth, as used by the QD library.
+// These depend on strict IEEE double rounding, so do not build with fast-math options
+
+/* Exact sum of two doubles */
+inline MclDoubleDouble twoSum(double _a, double _b)
+{
+	double s = _a + _b;
+	double bb = s - _a;
+	return MclDoubleDouble(s, (_a - (s - bb)) + (_b - bb));
+}
+
+/* Exact sum of two doubles, requires |_a| >= |_b| */
+inline MclDoubleDouble quickTwoSum(double _a, double _b)
+{
+	double s = _a + _b;
+	return MclDoubleDouble(s, _b - (s - _a));
+}
+
+/* Splits a double into two halves of 26 bits, so their products are exact */
+inline void splitDouble(double _a, double& _hi, double& _lo)
+{
+	double t = 134217729.0 * _a; // 2^27 + 1
+	_hi = t - (t - _a);
+	_lo = _a - _hi;
+}
+
+/* Exact product of two doubles */
+inline MclDoubleDouble twoProd(double _a, double _b)
+{
+	double p = _a * _b;
+	double aHi, aLo, bHi, bLo;
+	splitDouble(_a, aHi, aLo);
+	splitDouble(_b, bHi, bLo);
+	return MclDoubleDouble(p, ((aHi * bHi - p) + aHi * bLo + aLo * bHi) + aLo * bLo);
+}
+
+inline MclDoubleDouble operator+(const MclDoubleDouble& _a, const MclDoubleDouble& _b)
+{
+	MclDoubleDouble s = twoSum(_a.hi, _b.hi);
+	MclDoubleDouble t = twoSum(_a.lo, _b.lo);
+	s.lo += t.hi;
+	s = quickTwoSum(s.hi, s.lo);
+	s.lo += t.lo;
+	return quickTwoSum(s.hi, s.lo);
+}
+
+inline MclDoubleDouble operator-(const MclDoubleDouble& _a)
+{
+	return MclDoubleDouble(-_a.hi, -_a.lo);
+}
+
+inline MclDoubleDouble operator-(const MclDoubleDouble& _a, const MclDoubleDouble& _b)
+{
+	return _a + (-_b);
+}
+
+inline MclDoubleDouble operator*(const MclDoubleDouble& _a, const MclDoubleDouble& _b)
+{
+	MclDoubleDouble p = twoProd(_a.hi, _b.hi);
+	p.lo += _a.hi * _b.lo + _a.lo * _b.hi;
+	return quickTwoSum(p.hi, p.lo);
+}
+
+inline bool operator<(const MclDoubleDouble& _a, const MclDoubleDouble& _b)
+{
+	return _a.hi < _b.hi || (_a.hi == _b.hi && _a.lo < _b.lo);
+}
+
+/*** ~ BIG FIXED POINT ARITHMETIC ~ ***/
+
+inline bool isNegative(const MclBigFixed& _a)
+{
+	return (_a.limb[0] & 0x80000000u) != 0;
+}
+
+inline MclBigFixed operator+(const MclBigFixed& _a, const MclBigFixed& _b)
+{
+	MclBigFixed sum;
+	uint64_t carry = 0;
+	for (int i = BIGFIXED_LIMBS - 1; i >= 0; i--)
+	{
+		carry += (uint64_t)_a.limb[i] + _b.limb[i];
+		sum.limb[i] = (uint32_t)carry;
+		carry >>= 32;
+	}
+	return sum;
+}
+
+inline MclBigFixed operator-(const MclBigFixed& _a)
+{
+	MclBigFixed negated;
+	uint64_t carry = 1;
+	for (int i = BIGFIXED_LIMBS - 1; i >= 0; i--)
+	{
+		carry += (uint32_t)~_a.limb[i];
+		negated.limb[i] = (uint32_t)carry;
+		carry >>= 32;
+	}
+	return negated;
+}
+
+inline MclBigFixed operator-(const MclBigFixed& _a, const MclBigFixed& _b)
+{
+	return _a + (-_b);
+}
+
+/* Multiplies two numbers using only their first '_limbs' limbs, the rest of the product is truncated.
+The reference orbit uses this to only pay for the precision the zoom depth needs */
+MclBigFixed multiply(const MclBigFixed& _a, const MclBigFixed& _b, int _limbs)
+{
+	bool negative = isNegative(_a) != isNegative(_b);
+	MclBigFixed a = isNegative(_a) ? -_a : _a, b = isNegative(_b) ? -_b : _b;
+
+	// schoolbook multiplication of the magnitudes. product[p] holds the bits of weight 2^(-32 * (p - 1))
+	uint32_t product[2 * BIGFIXED_LIMBS] = {};
+	for (int i = _limbs - 1; i >= 0; i--)
+	{
+		uint64_t carry = 0;
+		for (int k = _limbs - 1; k >= 0; k--)
+		{
+			carry += (uint64_t)a.limb[i] * b.limb[k] + product[i + k + 1];
+			product[i + k + 1] = (uint32_t)carry;
+			carry >>= 32;
+		}
+		product[i] = (uint32_t)carry;
+	}
+
+	MclBigFixed result;
+	for (int i = 0; i < _limbs; i++) result.limb[i] = product[i + 1];
+	return negative ? -result : result;
+}
+
+inline MclBigFixed operator*(const MclBigFixed& _a, const MclBigFixed& _b)
+{
+	return multiply(_a, _b, BIGFIXED_LIMBS);
+}
+
+/* Rounds to double-double, from the first non-zero limb so that small values keep their precision */
+MclDoubleDouble toDoubleDouble(const MclBigFixed& _a)
+{
+	MclBigFixed magnitude = isNegative(_a) ? -_a : _a;
+	int first = 0;
+	while (first < BIGFIXED_LIMBS && magnitude.limb[first] == 0) first++;
+
+	MclDoubleDouble sum;
+	for (int i = first; i < std::min(first + 4, BIGFIXED_LIMBS); i++) sum = sum + MclDoubleDouble(ldexp((double)magnitude.limb[i], -32 * i));
+	return isNegative(_a) ? -sum : sum;
+}
+
+inline double toDouble(const MclBigFixed& _a)
+{
+	return toDoubleDouble(_a).hi;
+}
+
+/* Exact position of a pixel on the complex number plane, '_origin + _pixel * _pixelSize' */
+inline MclBigFixed toBigFixed(const MclBigFixed& _origin, double _pixel, double _pixelSize)
+{
+	MclDoubleDouble offset = twoProd(_pixel, _pixelSize);
+	return _origin + MclBigFixed(offset.hi) + MclBigFixed(offset.lo);
+}
+
+/* Divides a non-negative number by a small integer, truncating */
+MclBigFixed divide(const MclBigFixed& _a, uint32_t _divisor)
+{
+	MclBigFixed quotient;
+	uint64_t remainder = 0;
+	for (int i = 0; i < BIGFIXED_LIMBS; i++)
+	{
+		uint64_t current = (remainder << 32) | _a.limb[i];
+		quotient.limb[i] = (uint32_t)(current / _divisor);
+		remainder = current % _divisor;
+	}
+	return quotient;
+}
+
+/* Reads a decimal number such as "-0.743644786" in full precision, so deep zoom centres are not rounded to double.
+Returns false if '_text' is not a number or its integer part does not fit */
+bool parseBigFixed(const char* _text, MclBigFixed& _value)
+{
+	bool negative = *_text == '-';
+	if (*_text == '-' || *_text == '+') _text++;
+	const char* integerDigits = _text;
+	uint32_t integer = 0;
+	for (; *_text >= '0' && *_text <= '9'; _text++)
+	{
+		integer = integer * 10 + (*_text - '0');
+		if (integer >= 0x40000000u) return false;
+	}
+	bool hasIntegerDigits = _text != integerDigits;
+	const char* fractionDigits = *_text == '.' ? ++_text : _text;
+	while (*_text >= '0' && *_text <= '9') _text++;
+	if (*_text != '\0' || (!hasIntegerDigits && _text == fractionDigits)) return false;
+
+	// the fraction is built from its last digit up, each step a division by 10
+	MclBigFixed fraction;
+	for (const char* digit = _text - 1; digit >= fractionDigits; digit--)
+	{
+		fraction.limb[0] += *digit - '0';
+		fraction = divide(fraction, 10);
+	}
+	fraction.limb[0] = integer;
+	_value = negative ? -fraction : fraction;
+	return true;
+}
+
+/*** ~ GLOBAL CONSTANTS ~ ***/
+
+// Size of the window when it opens, it can be resized
+#define WINDOW_WIDTH 960
+#define WINDOW_HEIGHT 600
+
+// Most frames per second the window is drawn at when it opens, and the range the cap can be set to, see 'scaleFrameRateCap'
+#define DEFAULT_FRAME_RATE_CAP 60
+#define MIN_FRAME_RATE_CAP 15
+#define MAX_FRAME_RATE_CAP 960
+
+// Seconds the rendering thread sleeps at most while nothing changes. Everything which changes the window wakes it up
+// earlier (see 'damageDisplay'), so this only bounds how long it goes without looking
+#define RENDER_IDLE_TIMEOUT 0.5
+
+// Range of the render resolution relative to the window size. Below 1 renders fewer pixels and scales them up,
+// above 1 supersamples
+#define MIN_RENDER_SCALE 0.25
+#define MAX_RENDER_SCALE 2.0
+
+// maximum number of threads to calculate mandelbrot, enough for every hardware thread of a big dual socket machine
+#define MAX_THREADS 256
+
+// Width and Height of each tile of work given to the worker pool
+#define TILE_SIZE 32
+
+// value of 'tileStampArray' while a worker is writing the tile
+#define TILE_WRITING 0
+
+// Step between the pixels computed by the first pass of a progressive frame, each later pass halves it down to one.
+// Must divide TILE_SIZE, so every pass lines up with the tiles
+#define PROGRESSIVE_STEP 16
+
+// Rectangles smaller than this in either direction are computed pixel by pixel instead of being subdivided further
+#define SUBDIVIDE_MIN_SIZE 8
+
+// Low bits of a tile stamp which hold the step of the pass the tile is finished up to, see 'getTileStamp'
+#define TILE_STAMP_STEP_BITS 5
+
+// Step of the stamp of a tile which is finished at full resolution and has its edges anti-aliased, see 'antialiasTile'
+#define TILE_STEP_ANTIALIASED 0
+
+// Extra samples an edge pixel gets at most, filling a 4 x 4 grid with its base sample, and how many of them are taken
+// first to see if the pixel needs the rest
+#define AA_EXTRA_SAMPLES 15
+#define AA_FIRST_SAMPLES 3
+
+// Extra samples one tile may take. Half a sample per pixel keeps the anti-aliasing pass well below the cost of the frame
+#define AA_TILE_SAMPLES (TILE_SIZE * TILE_SIZE / 2)
+
+// Smallest difference of the smooth iteration counts of neighbouring samples which makes an edge. Samples only one
+// of which is in the set always make one
+#define AA_EDGE_THRESHOLD 2.0f
+
+// Memory the tile cache may use for iteration counts, in megabytes. The least recently used tiles are dropped past it
+#define TILE_CACHE_MEGABYTES 256
+
+// Milliseconds the cursor has to rest before the view a click there would zoom into is computed into the tile cache,
+// and how often the idle main loop collects those tiles, see 'prefetchWhileIdle'
+#define PREFETCH_HOVER_DELAY 100
+
+// File that keeps computed tiles between sessions, and its number of tile slots. 0 slots turns the file off
+#define TILE_STORE_PATH "mandelbrot.tiles"
+#define TILE_STORE_SLOTS 16384
+
+// file the trace of the worker pool is written to, see 'writeChromeTrace'
+#define TRACE_PATH "mandelbrot.trace.json"
+
+// Rows of the image the batch renderer computes at once. The back buffer only holds this many rows of the image
+#define BATCH_STRIP_ROWS 128
+
+// Version of the messages of the render farm. Workers only serve coordinators of the same version and BIGFIXED_LIMBS
+#define FARM_PROTOCOL_VERSION 2
+
+// Tiles a node of the render farm is given at once for each of its worker threads, and most tiles of one job
+#define FARM_TILES_PER_THREAD 4
+#define FARM_MAX_JOB_TILES 1024
+
+// Jobs sent to a node ahead of their results, so it has the next one while the tiles of the last one are on their way back
+#define FARM_JOBS_IN_FLIGHT 2
+
+// Milliseconds to connect to a node, to wait for the tiles of a job before the node counts as lost, and between attempts
+// to connect to a lost node again
+#define FARM_CONNECT_TIMEOUT 3000
+#define FARM_RECEIVE_TIMEOUT 60000
+#define FARM_RETRY_DELAY 2000
+
+// Largest message accepted from the other end of a render farm connection
+#define FARM_MAX_MESSAGE (64 << 20)
+
+// Rows in each strip of a TIFF file
+#define TIFF_STRIP_ROWS 32
+
+// image size and number of timed runs of each benchmark, unless they are given on the command line
+#define BENCH_WIDTH 640
+#define BENCH_HEIGHT 360
+#define BENCH_REPEATS 5
+
+// Number of tiles the view moves for each press of a pan key
+#define PAN_STEP_TILES 4
+
+// When the mandlebrot function reaches this many iterations, it is considered stable (does not go to infinity).
+// Default of the iteration limit, which can be changed at runtime
+#define DEFAULT_MAX_ITERATIONS 500
+
+// Range of the iteration limit
+#define MIN_MAX_ITERATIONS 16
+#define MAX_MAX_ITERATIONS (1 << 24)
+
+// Iterations added to the limit for every doubling of the zoom when the limit is adaptive
+#define ADAPTIVE_ITERATIONS_PER_OCTAVE 50
+
+// Given to points proven to be inside the set (bulb test or periodicity), whatever the iteration limit
+#define ITERATIONS_INTERIOR INT_MAX
+
+// Extra bits of precision a kernel needs beyond the pixel spacing, to absorb the rounding error built up over the iterations
+#define PRECISION_GUARD_BITS 8
+
+// Smallest size of a pixel on the complex number plane, the perturbation kernel keeps its deltas in doubles
+#define MIN_PIXEL_SIZE 1e-290
+
+// Number of times the perturbation kernel picks a new reference orbit for the glitched pixels of one kernel call
+#define MAX_REFERENCE_ROUNDS 8
+
+// A perturbed pixel is glitched when |z_n| drops below this fraction of |Z_n| of the reference (Pauldelbrot's criterion)
+#define GLITCH_TOLERANCE 1e-3
+
+// Periodicity checking only treats orbit points as equal when they are closer than this fraction of a pixel
+#define PERIODICITY_PIXEL_FRACTION 1e-3
+
+// Returned by 'iteratePerturbation' for pixels which need a different reference orbit
+#define ITERATIONS_GLITCHED -1
+
+// When |z|^2 reaches this value the point is known to go to infinity (same as |z| >= 2, without the square root)
+#define BAILOUT_SQUARED 4.0
+
+// highest power of z the kernels are compiled for, see 'MclFractal'
+#define MAX_POWER 4
+
+// The escape fraction of a pixel continues its orbit up to this |z|^2, for smooth colouring. A larger radius
+// makes the fraction more precise at a few extra iterations per pixel, see 'getEscapeFraction'
+#define SMOOTH_BAILOUT_SQUARED 1e8
+
+// Number of colours in a palette lookup table. Must be a power of two, so cyclic palettes wrap with a mask
+#define PALETTE_SIZE 1024
+
+// Iterations a cyclic palette takes to repeat
+#define PALETTE_CYCLE_ITERATIONS 64
+
+// Most bins of the iteration count histogram used for histogram equalisation. Iteration limits above it share bins
+#define HISTOGRAM_BINS 4096
+
+// Scale of the cursor zoom box
+#define CURSOR_BOX_SCALE 0.01
+
+// color of the cursor box
+const float colour[] = { 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0 };
+
+/*** ~ GLOBAL VARIABLES ~ ***/
+
+// position values of the box to draw around the cursor, used for zoom functionality also
+double cursorBox[8];
+
+// number of threads to compute mandlebrot set
+atomic_int threadCount = 1;
+
+// mutex to protect the 'threadCount' variable
+mutex threadCountMutex;
+
+// persistent worker threads which compute mandlebrot jobs. Started once, grown by 'resizeWorkerPool'
+vector<thread> workerList;
+
+// number of workers allowed to take jobs, the remaining workers stay parked
+int activeWorkerCount = 0;
+
+// number of worker threads started, the queues past it are always empty
+atomic_int spawnedWorkerCount = 0;
+
+// processors of the machine, found at startup by 'detectCpuTopology'
+MclCpuTopology cpuTopology;
+
+// are the workers pinned to the processors of 'cpuTopology', worker 'i' to 'cpuTopology.cpus[i]'? See 'toggleThreadPinning'
+atomic_bool threadPinning = false;
+
+// were the bands of the back buffers placed on the NUMA nodes of the pinned workers (see 'clearBackBuffer')? Only used by the main thread
+bool backBufferPlaced = false;
+
+// jobs waiting for a worker, one queue per worker
+MclWorkerQueue workerQueueArray[MAX_THREADS];
+
+// number of jobs sitting in the worker queues
+atomic_int queuedJobCount = 0;
+
+// number of jobs which are queued or currently being computed
+int pendingJobCount = 0;
+
+// has the worker pool been asked to exit?
+bool workerPoolShutdown = false;
+
+// mutex to protect the worker pool variables above ('workerQueueArray' has its own mutexes)
+mutex jobQueueMutex;
+
+// counters of each worker for the frame it last worked on, only read by the main thread while the workers are idle
+MclWorkerStats workerStatsArray[MAX_THREADS];
+
+// used for waking workers when jobs arrive, and the main thread when all jobs are done
+condition_variable jobAvailable;
+condition_variable jobsFinished;
+
+// current mandlebrot zoom values, in pixels of the window
+MclView view;
+
+// size of the window's framebuffer, changed by 'framebufferSizeCallback'
+atomic_int windowWidth = WINDOW_WIDTH, windowHeight = WINDOW_HEIGHT;
+
+// render resolution relative to the window size, see 'getRenderView'
+std::atomic<double> renderScale = 1.0;
+
+// iteration counts of the pixels of the frame being computed. Back buffer written by the workers, without locks.
+// The back buffers are sized for each frame by 'resizeBackBuffer'
+MclIterationBuffer pixels(WINDOW_WIDTH, WINDOW_HEIGHT);
+
+// iteration counts of the pixels shown in the window. Only used by the rendering thread, which copies finished tiles over from 'pixels'
+MclIterationBuffer displayPixels(WINDOW_WIDTH, WINDOW_HEIGHT);
+
+// last z of every pixel of the back buffer computed by a float or double kernel, so the orbits of pixels which reached the
+// iteration limit can be continued when it is raised. Written by the workers next to 'pixels'
+MclBuffer<MclOrbitState> orbitPixels(WINDOW_WIDTH, WINDOW_HEIGHT);
+
+// fraction of an iteration past its count in 'pixels' at which each pixel escaped, for smooth colouring (see 'getEscapeFraction'),
+// and the same for 'displayPixels'. Written and copied along with the iteration counts
+MclBuffer<float> fractionPixels(WINDOW_WIDTH, WINDOW_HEIGHT);
+MclBuffer<float> displayFractions(WINDOW_WIDTH, WINDOW_HEIGHT);
+
+// copy of the back buffer taken while tiles are moved to their new place after a pan. Only used by the main thread
+MclIterationBuffer previousPixels(WINDOW_WIDTH, WINDOW_HEIGHT);
+MclBuffer<float> previousFractions(WINDOW_WIDTH, WINDOW_HEIGHT);
+
+// copy of 'displayPixels' resampled into the new view when a frame starts. Only used by the rendering thread
+MclIterationBuffer resampledPixels(WINDOW_WIDTH, WINDOW_HEIGHT);
+MclBuffer<float> resampledFractions(WINDOW_WIDTH, WINDOW_HEIGHT);
+
+// number of the frame being computed, increased by the main thread for every new frame
+std::atomic<uint32_t> frameEpoch = 0;
+
+// view of the frame being computed, protected by 'frameViewMutex' together with increases of 'frameEpoch'
+mutex frameViewMutex;
+MclView frameView;
+
+// frame and pass each tile of 'pixels' was last finished for (see 'getTileStamp'), or TILE_WRITING while a worker writes it.
+// Together with 'frameEpoch' this is how finished tiles are published to the rendering thread
+std::unique_ptr<std::atomic<uint32_t>[]> tileStampArray;
+
+// jobs of each tile which have not finished yet. A subdivided tile is published when its last rectangle is done
+std::unique_ptr<std::atomic<int>[]> tileRemainingJobs;
+
+// frame (high 32 bits) and number (low 32 bits) of the jobs writing each tile, see 'enterTile'
+std::unique_ptr<std::atomic<uint64_t>[]> tileWriterArray;
+
+// number of tiles 'tileStampArray', 'tileRemainingJobs', 'tileWriterArray' and 'tileCostArray' have room for
+int tileCapacity = 0;
+
+// extra samples of the anti-aliased pixels of each tile of the back buffer, AA_TILE_SAMPLES for every tile, and how many of
+// them each tile uses. Sized with 'tileStampArray', written by 'antialiasTile' and copied along with the tile's pixels
+std::unique_ptr<MclAaSample[]> tileSampleArray;
+std::unique_ptr<int[]> tileSampleCounts;
+
+// the same for the tiles shown in the window. Only used by the rendering thread
+vector<MclAaSample> displaySamples;
+vector<int> displaySampleCounts;
+
+// time the jobs of each tile took in the current frame, in microseconds, summed over passes and subdivided rectangles.
+// Sized with 'tileStampArray', drawn by 'drawTileHeatmap'
+std::unique_ptr<std::atomic<int>[]> tileCostArray;
+
+// record every job for a trace, see 'writeChromeTrace'? The events of the finished frames are collected in 'traceEvents'
+// by the main thread, and the times of all of them are taken from 'sessionStart'
+atomic_bool traceRecording = false;
+vector<MclTraceEvent> traceEvents;
+const timer::time_point sessionStart = timer::now();
+
+// shade the tiles of the window by how long they took to compute?
+atomic_bool tileHeatmap = false;
+
+// index into 'kernelArray' of the kernel used to compute the mandelbrot set. -1 chooses the kernel from the zoom depth
+atomic_int kernelIndex = -1;
+
+// should the kernels use the main cardioid / bulb test and periodicity checking?
+atomic_bool interiorChecks = true;
+
+// iteration limit chosen by the user, see 'getMaxIterations'
+atomic_int maxIterations = DEFAULT_MAX_ITERATIONS;
+
+// raise the iteration limit with the zoom depth, ADAPTIVE_ITERATIONS_PER_OCTAVE for every doubling of the zoom?
+atomic_bool adaptiveIterations = false;
+
+// use the perturbation kernel instead of long double and double-double once double is not precise enough?
+atomic_bool preferPerturbation = true;
+
+// compute frames in coarse to fine passes, starting at PROGRESSIVE_STEP?
+atomic_bool progressiveRendering = true;
+
+// compute frames with Mariani-Silver subdivision, filling rectangles with a uniform border without computing them?
+// Takes the place of progressive rendering while it is on
+atomic_bool subdivision = false;
+
+// index into 'paletteArray' of the palette the colour pass uses
+atomic_int paletteIndex = 0;
+
+// colour with the fraction of an iteration each pixel escaped at, instead of in bands of whole iterations?
+atomic_bool smoothColouring = true;
+
+// spread the colours of the palette evenly over the pixels of the frame, by the histogram of its iteration counts?
+atomic_bool histogramEqualisation = false;
+
+// set when a colour setting changed, so the rendering thread colours every tile again without recomputing the frame
+atomic_bool recolourPixels = false;
+
+// give the edge pixels of finished frames extra samples, see 'antialiasTile'?
+atomic_bool antialiasing = true;
+
+// keep computed tiles by their exact position, and fill frames from them? See the TILE CACHE section
+atomic_bool tileCaching = true;
+
+// tiles computed in this session, and the tiles kept on disk between sessions. Only used by the main thread
+MclTileCache tileCache;
+MclTileStore tileStore;
+
+// iteration map given with --open, which frames of its pixel size are filled from. Opened before the rendering thread
+// starts and not changed afterwards, its tiles are decoded into the cache by the main thread
+MclIterationMap iterationMap;
+
+// worker processes sharing the frames of a batch render, see the DISTRIBUTED RENDERING section
+MclRenderFarm renderFarm;
+
+// compute the view a left click would zoom into while the workers are idle, so the click finds its tiles in the cache?
+atomic_bool speculativePrefetch = true;
+
+// number of times the cursor moved, so the main loop can tell when it rests somewhere (see 'prefetchWhileIdle' and 'renderRequestMutex')
+std::atomic<uint32_t> hoverGeneration = 0;
+
+// tiles the workers computed speculatively, waiting for the main thread to add them to 'tileCache'
+mutex prefetchMutex;
+vector<MclTileCacheEntry> prefetchedTiles;
+
+// highest instruction set extension supported by this CPU (and OS)
+MclCpuFeature cpuFeature = CPU_SCALAR;
+
+// where the mandelbrot set is computed, see 'MclBackend'
+atomic_int backend = BACKEND_CPU;
+
+// view for the rendering thread to compute with the GPU backend, and whether it still has to.
+// The main thread waits on 'gpuFrameFinished' until the rendering thread finished or cancelled the frame
+mutex gpuFrameMutex;
+condition_variable gpuFrameFinished;
+MclView gpuFrameView;
+bool gpuFramePending = false;
+
+// render request of the UI callbacks for the main loop: the window's view when a setting last changed, and its generation.
+// A new request replaces the one not taken yet, so the main loop skips the views in between (see 'takeRenderRequest').
+// 'requestedView', 'viewGeneration' and 'hoverGeneration' only change with 'renderRequestMutex' held, so the main loop
+// waiting on 'renderRequested' cannot miss one
+mutex renderRequestMutex;
+condition_variable renderRequested;
+MclView requestedView;
+
+// number of changes to the view or the settings, increased by 'signalRecalculation'. A frame is stale once this differs from the
+// generation of its view: the main thread starts the next frame, and the workers drop the old frame's jobs (see 'isStale')
+std::atomic<uint32_t> viewGeneration = 0;
+
+// has the GLFW window been closed?
+atomic_bool windowClosed = false;
+
+// does the window have to be drawn again for something other than new tiles (cursor moved, window uncovered)?
+atomic_bool redrawWindow = true;
+
+// may there be something new for the rendering thread since it last looked (tiles published, a GPU frame pending)?
+// Set by 'damageDisplay', and only cleared by the rendering thread, so nobody wakes it before its loop runs or in batch mode
+atomic_bool displayDamaged = true;
+
+// wait for the vertical blank before showing a frame, and the most frames per second the window is drawn at
+atomic_bool vsync = true;
+atomic_int frameRateCap = DEFAULT_FRAME_RATE_CAP;
+
+/*** ~ KERNELS ~ ***/
+
+// GCC and Clang only allow AVX intrinsics in functions compiled for that instruction set, MSVC allows them anywhere.
+// The kernels are only called after 'detectCpuFeature' has checked that the CPU supports them
+#ifdef _MSC_VER
+#define MCL_TARGET_AVX2
+#define MCL_TARGET_AVX512
+#else
+#define MCL_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define MCL_TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+/* Converts a pixel position into a position on the complex number plane, in the precision of the kernel.
+float and double only need the leading part of the origin, their tier is only chosen while the pixel spacing is large */
+template <typename T>
+inline T toPlane(const MclDoubleDouble& _origin, double _pixel, double _pixelSize)
+{
+	return (T)(_origin.hi + _pixel * _pixelSize);
+}
+
+template <>
+inline long double toPlane<long double>(const MclDoubleDouble& _origin, double _pixel, double _pixelSize)
+{
+	return (long double)_origin.hi + (long double)_origin.lo + (long double)_pixel * (long double)_pixelSize;
+}
+
+template <>
+inline MclDoubleDouble toPlane<MclDoubleDouble>(const MclDoubleDouble& _origin, double _pixel, double _pixelSize)
+{
+	return _origin + twoProd(_pixel, _pixelSize);
+}
+
+/* Is the point inside the main cardioid or the period-2 bulb? Those points never escape, so
+they can skip the iteration. Tested in double, close to their boundary the escape time is
+far beyond the iteration limit anyway */
+inline bool isInMainBulbs(double _cr, double _ci)
+{
+	double xq = _cr - 0.25, y2 = _ci * _ci;
+	double q = xq * xq + y2;
+	if (q * (q + xq) <= 0.25 * y2) return true;
+	double xb = _cr + 1.0;
+	return xb * xb + y2 <= 0.0625;
+}
+
+/* Copies up to '_lanes' points starting at '_first' into fixed size blocks for the SIMD kernels.
+Blocks past '_count' are padded with a point outside the set. Returns a bit mask of the padding lanes, which the
+kernels leave alone, and with '_interiorChecks' of the lanes inside the main cardioid or bulb */
+template <typename T>
+int loadKernelBlock(const MclView& _view, const double* _px, const double* _py, int _first, int _count, int _lanes, bool _interiorChecks, T* _crBlock, T* _ciBlock)
+{
+	int interior = 0;
+	for (int lane = 0; lane < _lanes; lane++)
+	{
+		bool inside = _first + lane < _count;
+		_crBlock[lane] = inside ? toPlane<T>(_view.left, _px[_first + lane], _view.pixelWidth) : (T)BAILOUT_SQUARED;
+		_ciBlock[lane] = inside ? toPlane<T>(_view.top, _py[_first + lane], _view.pixelHeight) : (T)0.0;
+		if (!inside || (_interiorChecks && isInMainBulbs(toPlane<double>(_view.left, _px[_first + lane], _view.pixelWidth), toPlane<double>(_view.top, _py[_first + lane], _view.pixelHeight)))) interior |= 1 << lane;
+	}
+	return interior;
+}
+
+/* Copies the orbits of up to '_lanes' points starting at '_first' into fixed size blocks for the SIMD kernels
+which continue them. Blocks past '_count' are padded with z = 0 */
+template <typename T>
+void loadOrbitBlock(const MclOrbitState* _orbits, int _first, int _count, int _lanes, T* _zrBlock, T* _ziBlock)
+{
+	for (int lane = 0; lane < _lanes; lane++)
+	{
+		bool inside = _first + lane < _count;
+		_zrBlock[lane] = inside ? (T)_orbits[_first + lane].zr : (T)0.0;
+		_ziBlock[lane] = inside ? (T)_orbits[_first + lane].zi : (T)0.0;
+	}
+}
+
+/* Relative rounding error of one operation in each precision */
+template <typename T>
+inline double getMachineEpsilon()
+{
+	return std::numeric_limits<T>::epsilon();
+}
+
+template <>
+inline double getMachineEpsilon<MclDoubleDouble>()
+{
+	return ldexp(1.0, -2 * DBL_MANT_DIG + 2);
+}
+
+/* Squared distance below which two orbit points count as the same point for periodicity checking.
+An attracting cycle gets that close, while escaping orbits never stay that close. It is kept well below the
+pixel size: near pre-periodic points an escaping orbit shadows a repelling cycle at about the distance of the
+pixel from that point. Once that distance is below the rounding error of |z| ~ 2, many orbits would look
+periodic after rounding, so the check is turned off (returns 0) */
+template <typename T>
+inline double getPeriodicityEpsilon(const MclView& _view)
+{
+	double maxDistance = std::is_same<T, float>::value ? 1e-5 : 1e-12;
+	double distance = std::min(maxDistance, PERIODICITY_PIXEL_FRACTION * std::min(fabs(_view.pixelWidth), fabs(_view.pixelHeight)));
+	return distance > 4.0 * getMachineEpsilon<T>() ? distance * distance : 0.0;
+}
+
+/* Calls '_function' with the formula and power of '_fractal' as compile time constants (std::integral_constant),
+so every combination gets kernels of its own whose inner loop does not branch on them */
+template <int Formula, int Power, typename F>
+inline auto dispatchPower(int _power, F& _function)
+{
+	if constexpr (Power < MAX_POWER)
+	{
+		if (_power > Power) return dispatchPower<Formula, Power + 1>(_power, _function);
+	}
+	return _function(std::integral_constant<int, Formula>(), std::integral_constant<int, Power>());
+}
+
+template <typename F>
+inline auto dispatchFractal(const MclFractal& _fractal, F _function)
+{
+	switch (_fractal.formula)
+	{
+	case FORMULA_JULIA: return dispatchPower<FORMULA_JULIA, 2>(_fractal.power, _function);
+	case FORMULA_BURNING_SHIP: return dispatchPower<FORMULA_BURNING_SHIP, 2>(_fractal.power, _function);
+	default: return dispatchPower<FORMULA_MANDELBROT, 2>(_fractal.power, _function);
+	}
+}
+
+/* Does the main cardioid and period-2 bulb test ('isInMainBulbs') hold for the formula and power? */
+template <int Formula, int Power>
+constexpr bool hasMainBulbs()
+{
+	return Formula == FORMULA_MANDELBROT && Power == 2;
+}
+
+/* Checks if two views show the same fractal */
+inline bool isSameFractal(const MclFractal& _a, const MclFractal& _b)
+{
+	return _a.formula == _b.formula && _a.power == _b.power && _a.juliaR == _b.juliaR && _a.juliaI == _b.juliaI;
+}
+
+/* Is '_fractal' the quadratic Mandelbrot set, the only fractal the perturbation kernel and the GPU backends compute? */
+inline bool isQuadraticMandelbrot(const MclFractal& _fractal)
+{
+	return _fractal.formula == FORMULA_MANDELBROT && _fractal.power == 2;
+}
+
+/* One iteration of the formula, '_zr2' and '_zi2' are the squares of z the caller has for the bailout test already.
+With power 2 this is the same arithmetic as the plain Mandelbrot iteration, higher powers multiply z out */
+template <int Formula, int Power, typename T>
+inline void stepFormula(T& _zr, T& _zi, const T& _zr2, const T& _zi2, const T& _cr, const T& _ci)
+{
+	if constexpr (Formula == FORMULA_BURNING_SHIP)
+	{
+		if (_zr < (T)0.0) _zr = -_zr;
+		if (_zi < (T)0.0) _zi = -_zi;
+	}
+	if constexpr (Power == 2)
+	{
+		T zri = _zr * _zi;
+		_zi = zri + zri + _ci;
+		_zr = _zr2 - _zi2 + _cr;
+	}
+	else
+	{
+		T wr = _zr, wi = _zi;
+		for (int k = 1; k < Power; k++)
+		{
+			T r = wr * _zr - wi * _zi;
+			wi = wr * _zi + wi * _zr;
+			wr = r;
+		}
+		_zr = wr + _cr;
+		_zi = wi + _ci;
+	}
+}
+
+/* Portable kernel, one point at a time. Used for every precision, including long double and double-double.
+With 'InteriorChecks' the main bulbs are skipped (if the formula has them), and Brent's cycle detection stops
+points whose orbit comes back to the point saved at the last power of two iteration */
+template <typename T, int Formula, int Power, bool InteriorChecks, bool Resume>
+long long kernelScalarImpl(const MclView& _view, const double* _px, const double* _py, int _count, int* _iterations, MclOrbitState* _orbits)
+{
+	const T bailout = BAILOUT_SQUARED;
+	const T epsilon = getPeriodicityEpsilon<T>(_view);
+	const int start = Resume ? _iterations[0] : 0;
+	long long total = 0;
+	for (int i = 0; i < _count; i++)
+	{
+		if (InteriorChecks && hasMainBulbs<Formula, Power>() && isInMainBulbs(toPlane<double>(_view.left, _px[i], _view.pixelWidth), toPlane<double>(_view.top, _py[i], _view.pixelHeight)))
+		{
+			_iterations[i] = ITERATIONS_INTERIOR;
+			continue;
+		}
+
+		T cr = toPlane<T>(_view.left, _px[i], _view.pixelWidth), ci = toPlane<T>(_view.top, _py[i], _view.pixelHeight);
+		T zr = Resume ? (T)_orbits[i].zr : (T)0.0, zi = Resume ? (T)_orbits[i].zi : (T)0.0;
+		if constexpr (Formula == FORMULA_JULIA)
+		{
+			if (!Resume)
+			{
+				zr = cr;
+				zi = ci;
+			}
+			cr = (T)_view.fractal.juliaR;
+			ci = (T)_view.fractal.juliaI;
+		}
+		T zr2 = zr * zr, zi2 = zi * zi;
+		T savedZr = zr, savedZi = zi;
+		int checkpoint = 1;
+		int iterations = start;
+		bool periodic = false;
+		while (zr2 + zi2 < bailout && iterations < _view.maxIterations)
+		{
+			stepFormula<Formula, Power>(zr, zi, zr2, zi2, cr, ci);
+			zr2 = zr * zr;
+			zi2 = zi * zi;
+			++iterations;
+
+			if (InteriorChecks)
+			{
+				T dr = zr - savedZr, di = zi - savedZi;
+				if (dr * dr + di * di < epsilon)
+				{
+					periodic = true;
+					break;
+				}
+				if (iterations - start == checkpoint)
+				{
+					savedZr = zr;
+					savedZi = zi;
+					checkpoint *= 2;
+				}
+			}
+		}
+		_iterations[i] = periodic ? ITERATIONS_INTERIOR : iterations;
+		total += iterations - start;
+		if constexpr (std::is_same<T, float>::value || std::is_same<T, double>::value)
+		{
+			_orbits[i].zr = zr;
+			_orbits[i].zi = zi;
+		}
+	}
+	return total;
+}
+
+template <typename T, bool Resume = false>
+long long kernelScalar(const MclView& _view, const double* _px, const double* _py, int _count, int* _iterations, MclOrbitState* _orbits)
+{
+	return dispatchFractal(_view.fractal, [&](auto _formula, auto _power)
+	{
+		constexpr int Formula = decltype(_formula)::value, Power = decltype(_power)::value;
+		if (_view.interiorChecks) return kernelScalarImpl<T, Formula, Power, true, Resume>(_view, _px, _py, _count, _iterations, _orbits);
+		else return kernelScalarImpl<T, Formula, Power, false, Resume>(_view, _px, _py, _count, _iterations, _orbits);
+	});
+}
+
+/* 'stepFormula' for each of the SIMD kernels */
+template <int Formula, int Power>
+MCL_TARGET_AVX2 inline void stepAvx2Double(__m256d& _zr, __m256d& _zi, __m256d _zr2, __m256d _zi2, __m256d _cr, __m256d _ci)
+{
+	if constexpr (Formula == FORMULA_BURNING_SHIP)
+	{
+		const __m256d sign = _mm256_set1_pd(-0.0);
+		_zr = _mm256_andnot_pd(sign, _zr);
+		_zi = _mm256_andnot_pd(sign, _zi);
+	}
+	if constexpr (Power == 2)
+	{
+		_zi = _mm256_fmadd_pd(_mm256_add_pd(_zr, _zr), _zi, _ci);
+		_zr = _mm256_add_pd(_mm256_sub_pd(_zr2, _zi2), _cr);
+	}
+	else
+	{
+		__m256d wr = _zr, wi = _zi;
+		for (int k = 1; k < Power; k++)
+		{
+			__m256d r = _mm256_fmsub_pd(wr, _zr, _mm256_mul_pd(wi, _zi));
+			wi = _mm256_fmadd_pd(wr, _zi, _mm256_mul_pd(wi, _zr));
+			wr = r;
+		}
+		_zr = _mm256_add_pd(wr, _cr);
+		_zi = _mm256_add_pd(wi, _ci);
+	}
+}
+
+template <int Formula, int Power>
+MCL_TARGET_AVX2 inline void stepAvx2Float(__m256& _zr, __m256& _zi, __m256 _zr2, __m256 _zi2, __m256 _cr, __m256 _ci)
+{
+	if constexpr (Formula == FORMULA_BURNING_SHIP)
+	{
+		const __m256 sign = _mm256_set1_ps(-0.0f);
+		_zr = _mm256_andnot_ps(sign, _zr);
+		_zi = _mm256_andnot_ps(sign, _zi);
+	}
+	if constexpr (Power == 2)
+	{
+		_zi = _mm256_fmadd_ps(_mm256_add_ps(_zr, _zr), _zi, _ci);
+		_zr = _mm256_add_ps(_mm256_sub_ps(_zr2, _zi2), _cr);
+	}
+	else
+	{
+		__m256 wr = _zr, wi = _zi;
+		for (int k = 1; k < Power; k++)
+		{
+			__m256 r = _mm256_fmsub_ps(wr, _zr, _mm256_mul_ps(wi, _zi));
+			wi = _mm256_fmadd_ps(wr, _zi, _mm256_mul_ps(wi, _zr));
+			wr = r;
+		}
+		_zr = _mm256_add_ps(wr, _cr);
+		_zi = _mm256_add_ps(wi, _ci);
+	}
+}
+
+template <int Formula, int Power>
+MCL_TARGET_AVX512 inline void stepAvx512Double(__m512d& _zr, __m512d& _zi, __m512d _zr2, __m512d _zi2, __m512d _cr, __m512d _ci)
+{
+	if constexpr (Formula == FORMULA_BURNING_SHIP)
+	{
+		_zr = _mm512_abs_pd(_zr);
+		_zi = _mm512_abs_pd(_zi);
+	}
+	if constexpr (Power == 2)
+	{
+		_zi = _mm512_fmadd_pd(_mm512_add_pd(_zr, _zr), _zi, _ci);
+		_zr = _mm512_add_pd(_mm512_sub_pd(_zr2, _zi2), _cr);
+	}
+	else
+	{
+		__m512d wr = _zr, wi = _zi;
+		for (int k = 1; k < Power; k++)
+		{
+			__m512d r = _mm512_fmsub_pd(wr, _zr, _mm512_mul_pd(wi, _zi));
+			wi = _mm512_fmadd_pd(wr, _zi, _mm512_mul_pd(wi, _zr));
+			wr = r;
+		}
+		_zr = _mm512_add_pd(wr, _cr);
+		_zi = _mm512_add_pd(wi, _ci);
+	}
+}
+
+template <int Formula, int Power>
+MCL_TARGET_AVX512 inline void stepAvx512Float(__m512& _zr, __m512& _zi, __m512 _zr2, __m512 _zi2, __m512 _cr, __m512 _ci)
+{
+	if constexpr (Formula == FORMULA_BURNING_SHIP)
+	{
+		_zr = _mm512_abs_ps(_zr);
+		_zi = _mm512_abs_ps(_zi);
+	}
+	if constexpr (Power == 2)
+	{
+		_zi = _mm512_fmadd_ps(_mm512_add_ps(_zr, _zr), _zi, _ci);
+		_zr = _mm512_add_ps(_mm512_sub_ps(_zr2, _zi2), _cr);
+	}
+	else
+	{
+		__m512 wr = _zr, wi = _zi;
+		for (int k = 1; k < Power; k++)
+		{
+			__m512 r = _mm512_fmsub_ps(wr, _zr, _mm512_mul_ps(wi, _zi));
+			wi = _mm512_fmadd_ps(wr, _zi, _mm512_mul_ps(wi, _zr));
+			wr = r;
+		}
+		_zr = _mm512_add_ps(wr, _cr);
+		_zi = _mm512_add_ps(wi, _ci);
+	}
+}
+
+/* AVX2 kernel, 4 points per block in double precision. Lanes which have escaped are masked out of the count,
+lanes found to be interior (bulb test or periodicity) are given ITERATIONS_INTERIOR */
+template <int Formula, int Power, bool InteriorChecks, bool Resume>
+MCL_TARGET_AVX2 long long kernelAvx2DoubleImpl(const MclView& _view, const double* _px, const double* _py, int _count, int* _iterations, MclOrbitState* _orbits)
+{
+	alignas(32) double crBlock[4], ciBlock[4], zrBlock[4], ziBlock[4];
+	alignas(32) long long itBlock[4];
+	const __m256d bailout = _mm256_set1_pd(BAILOUT_SQUARED), epsilon = _mm256_set1_pd(getPeriodicityEpsilon<double>(_view));
+	const int start = Resume ? _iterations[0] : 0;
+	long long total = 0;
+	for (int i = 0; i < _count; i += 4)
+	{
+		int interior = loadKernelBlock(_view, _px, _py, i, _count, 4, InteriorChecks && hasMainBulbs<Formula, Power>(), crBlock, ciBlock);
+		__m256d cr = _mm256_load_pd(crBlock), ci = _mm256_load_pd(ciBlock);
+		if (Resume) loadOrbitBlock(_orbits, i, _count, 4, zrBlock, ziBlock);
+		__m256d zr = Resume ? _mm256_load_pd(zrBlock) : _mm256_setzero_pd(), zi = Resume ? _mm256_load_pd(ziBlock) : _mm256_setzero_pd();
+		if constexpr (Formula == FORMULA_JULIA)
+		{
+			if (!Resume)
+			{
+				zr = cr;
+				zi = ci;
+			}
+			cr = _mm256_set1_pd(_view.fractal.juliaR);
+			ci = _mm256_set1_pd(_view.fractal.juliaI);
+		}
+		__m256d savedZr = zr, savedZi = zi, escapedZr = zr, escapedZi = zi;
+		__m256d active = _mm256_castsi256_pd(_mm256_set_epi64x(interior & 8 ? 0 : -1, interior & 4 ? 0 : -1, interior & 2 ? 0 : -1, interior & 1 ? 0 : -1));
+		__m256i count = _mm256_set1_epi64x(start);
+		for (int iterations = start, checkpoint = 1; iterations < _view.maxIterations; ++iterations)
+		{
+			__m256d zr2 = _mm256_mul_pd(zr, zr), zi2 = _mm256_mul_pd(zi, zi);
+			__m256d inside = _mm256_and_pd(active, _mm256_cmp_pd(_mm256_add_pd(zr2, zi2), bailout, _CMP_LT_OQ));
+			__m256d escaping = _mm256_andnot_pd(inside, active);
+			escapedZr = _mm256_blendv_pd(escapedZr, zr, escaping);
+			escapedZi = _mm256_blendv_pd(escapedZi, zi, escaping);
+			active = inside;
+			if (_mm256_movemask_pd(active) == 0) break;
+			count = _mm256_sub_epi64(count, _mm256_castpd_si256(active)); // active lanes are all ones (-1)
+			stepAvx2Double<Formula, Power>(zr, zi, zr2, zi2, cr, ci);
+
+			if (InteriorChecks)
+			{
+				__m256d dr = _mm256_sub_pd(zr, savedZr), di = _mm256_sub_pd(zi, savedZi);
+				__m256d periodic = _mm256_and_pd(active, _mm256_cmp_pd(_mm256_fmadd_pd(dr, dr, _mm256_mul_pd(di, di)), epsilon, _CMP_LT_OQ));
+				interior |= _mm256_movemask_pd(periodic);
+				active = _mm256_andnot_pd(periodic, active);
+				if (iterations + 1 - start == checkpoint)
+				{
+					savedZr = zr;
+					savedZi = zi;
+					checkpoint *= 2;
+				}
+			}
+		}
+		_mm256_store_si256((__m256i*)itBlock, count);
+		_mm256_store_pd(zrBlock, _mm256_blendv_pd(escapedZr, zr, active));
+		_mm256_store_pd(ziBlock, _mm256_blendv_pd(escapedZi, zi, active));
+		for (int lane = 0; lane < 4 && i + lane < _count; lane++)
+		{
+			_iterations[i + lane] = (interior >> lane) & 1 ? ITERATIONS_INTERIOR : (int)itBlock[lane];
+			total += itBlock[lane] - start;
+			_orbits[i + lane].zr = zrBlock[lane];
+			_orbits[i + lane].zi = ziBlock[lane];
+		}
+	}
+	return total;
+}
+
+template <bool Resume>
+long long kernelAvx2Double(const MclView& _view, const double* _px, const double* _py, int _count, int* _iterations, MclOrbitState* _orbits)
+{
+	return dispatchFractal(_view.fractal, [&](auto _formula, auto _power)
+	{
+		constexpr int Formula = decltype(_formula)::value, Power = decltype(_power)::value;
+		if (_view.interiorChecks) return kernelAvx2DoubleImpl<Formula, Power, true, Resume>(_view, _px, _py, _count, _iterations, _orbits);
+		else return kernelAvx2DoubleImpl<Formula, Power, false, Resume>(_view, _px, _py, _count, _iterations, _orbits);
+	});
+}
+
+/* AVX2 kernel, 8 points per block in single precision */
+template <int Formula, int Power, bool InteriorChecks, bool Resume>
+MCL_TARGET_AVX2 long long kernelAvx2FloatImpl(const MclView& _view, const double* _px, const double* _py, int _count, int* _iterations, MclOrbitState* _orbits)
+{
+	alignas(32) float crBlock[8], ciBlock[8], zrBlock[8], ziBlock[8];
+	alignas(32) int itBlock[8], activeBlock[8];
+	const __m256 bailout = _mm256_set1_ps((float)BAILOUT_SQUARED), epsilon = _mm256_set1_ps((float)getPeriodicityEpsilon<float>(_view));
+	const int start = Resume ? _iterations[0] : 0;
+	long long total = 0;
+	for (int i = 0; i < _count; i += 8)
+	{
+		int interior = loadKernelBlock(_view, _px, _py, i, _count, 8, InteriorChecks && hasMainBulbs<Formula, Power>(), crBlock, ciBlock);
+		for (int lane = 0; lane < 8; lane++) activeBlock[lane] = (interior >> lane) & 1 ? 0 : -1;
+		__m256 cr = _mm256_load_ps(crBlock), ci = _mm256_load_ps(ciBlock);
+		if (Resume) loadOrbitBlock(_orbits, i, _count, 8, zrBlock, ziBlock);
+		__m256 zr = Resume ? _mm256_load_ps(zrBlock) : _mm256_setzero_ps(), zi = Resume ? _mm256_load_ps(ziBlock) : _mm256_setzero_ps();
+		if constexpr (Formula == FORMULA_JULIA)
+		{
+			if (!Resume)
+			{
+				zr = cr;
+				zi = ci;
+			}
+			cr = _mm256_set1_ps((float)_view.fractal.juliaR);
+			ci = _mm256_set1_ps((float)_view.fractal.juliaI);
+		}
+		__m256 savedZr = zr, savedZi = zi, escapedZr = zr, escapedZi = zi;
+		__m256 active = _mm256_castsi256_ps(_mm256_load_si256((const __m256i*)activeBlock));
+		__m256i count = _mm256_set1_epi32(start);
+		for (int iterations = start, checkpoint = 1; iterations < _view.maxIterations; ++iterations)
+		{
+			__m256 zr2 = _mm256_mul_ps(zr, zr), zi2 = _mm256_mul_ps(zi, zi);
+			__m256 inside = _mm256_and_ps(active, _mm256_cmp_ps(_mm256_add_ps(zr2, zi2), bailout, _CMP_LT_OQ));
+			__m256 escaping = _mm256_andnot_ps(inside, active);
+			escapedZr = _mm256_blendv_ps(escapedZr, zr, escaping);
+			escapedZi = _mm256_blendv_ps(escapedZi, zi, escaping);
+			active = inside;
+			if (_mm256_movemask_ps(active) == 0) break;
+			count = _mm256_sub_epi32(count, _mm256_castps_si256(active));
+			stepAvx2Float<Formula, Power>(zr, zi, zr2, zi2, cr, ci);
+
+			if (InteriorChecks)
+			{
+				__m256 dr = _mm256_sub_ps(zr, savedZr), di = _mm256_sub_ps(zi, savedZi);
+				__m256 periodic = _mm256_and_ps(active, _mm256_cmp_ps(_mm256_fmadd_ps(dr, dr, _mm256_mul_ps(di, di)), epsilon, _CMP_LT_OQ));
+				interior |= _mm256_movemask_ps(periodic);
+				active = _mm256_andnot_ps(periodic, active);
+				if (iterations + 1 - start == checkpoint)
+				{
+					savedZr = zr;
+					savedZi = zi;
+					checkpoint *= 2;
+				}
+			}
+		}
+		_mm256_store_si256((__m256i*)itBlock, count);
+		_mm256_store_ps(zrBlock, _mm256_blendv_ps(escapedZr, zr, active));
+		_mm256_store_ps(ziBlock, _mm256_blendv_ps(escapedZi, zi, active));
+		for (int lane = 0; lane < 8 && i + lane < _count; lane++)
+		{
+			_iterations[i + lane] = (interior >> lane) & 1 ? ITERATIONS_INTERIOR : itBlock[lane];
+			total += itBlock[lane] - start;
+			_orbits[i + lane].zr = zrBlock[lane];
+			_orbits[i + lane].zi = ziBlock[lane];
+		}
+	}
+	return total;
+}
+
+template <bool Resume>
+long long kernelAvx2Float(const MclView& _view, const double* _px, const double* _py, int _count, int* _iterations, MclOrbitState* _orbits)
+{
+	return dispatchFractal(_view.fractal, [&](auto _formula, auto _power)
+	{
+		constexpr int Formula = decltype(_formula)::value, Power = decltype(_power)::value;
+		if (_view.interiorChecks) return kernelAvx2FloatImpl<Formula, Power, true, Resume>(_view, _px, _py, _count, _iterations, _orbits);
+		else return kernelAvx2FloatImpl<Formula, Power, false, Resume>(_view, _px, _py, _count, _iterations, _orbits);
+	});
+}
+
+/* AVX-512 kernel, 8 points per block in double precision. Uses mask registers for the active lanes */
+template <int Formula, int Power, bool InteriorChecks, bool Resume>
+MCL_TARGET_AVX512 long long kernelAvx512DoubleImpl(const MclView& _view, const double* _px, const double* _py, int _count, int* _iterations, MclOrbitState* _orbits)
+{
+	alignas(64) double crBlock[8], ciBlock[8], zrBlock[8], ziBlock[8];
+	alignas(64) long long itBlock[8];
+	const __m512d bailout = _mm512_set1_pd(BAILOUT_SQUARED), epsilon = _mm512_set1_pd(getPeriodicityEpsilon<double>(_view));
+	const __m512i one = _mm512_set1_epi64(1);
+	const int start = Resume ? _iterations[0] : 0;
+	long long total = 0;
+	for (int i = 0; i < _count; i += 8)
+	{
+		int interior = loadKernelBlock(_view, _px, _py, i, _count, 8, InteriorChecks && hasMainBulbs<Formula, Power>(), crBlock, ciBlock);
+		__m512d cr = _mm512_load_pd(crBlock), ci = _mm512_load_pd(ciBlock);
+		if (Resume) loadOrbitBlock(_orbits, i, _count, 8, zrBlock, ziBlock);
+		__m512d zr = Resume ? _mm512_load_pd(zrBlock) : _mm512_setzero_pd(), zi = Resume ? _mm512_load_pd(ziBlock) : _mm512_setzero_pd();
+		if constexpr (Formula == FORMULA_JULIA)
+		{
+			if (!Resume)
+			{
+				zr = cr;
+				zi = ci;
+			}
+			cr = _mm512_set1_pd(_view.fractal.juliaR);
+			ci = _mm512_set1_pd(_view.fractal.juliaI);
+		}
+		__m512d savedZr = zr, savedZi = zi, escapedZr = zr, escapedZi = zi;
+		__mmask8 active = (__mmask8)~interior;
+		__m512i count = _mm512_set1_epi64(start);
+		for (int iterations = start, checkpoint = 1; iterations < _view.maxIterations; ++iterations)
+		{
+			__m512d zr2 = _mm512_mul_pd(zr, zr), zi2 = _mm512_mul_pd(zi, zi);
+			__mmask8 inside = _mm512_mask_cmp_pd_mask(active, _mm512_add_pd(zr2, zi2), bailout, _CMP_LT_OQ);
+			escapedZr = _mm512_mask_mov_pd(escapedZr, active & ~inside, zr);
+			escapedZi = _mm512_mask_mov_pd(escapedZi, active & ~inside, zi);
+			active = inside;
+			if (active == 0) break;
+			count = _mm512_mask_add_epi64(count, active, count, one);
+			stepAvx512Double<Formula, Power>(zr, zi, zr2, zi2, cr, ci);
+
+			if (InteriorChecks)
+			{
+				__m512d dr = _mm512_sub_pd(zr, savedZr), di = _mm512_sub_pd(zi, savedZi);
+				__mmask8 periodic = _mm512_mask_cmp_pd_mask(active, _mm512_fmadd_pd(dr, dr, _mm512_mul_pd(di, di)), epsilon, _CMP_LT_OQ);
+				interior |= periodic;
+				active &= ~periodic;
+				if (iterations + 1 - start == checkpoint)
+				{
+					savedZr = zr;
+					savedZi = zi;
+					checkpoint *= 2;
+				}
+			}
+		}
+		_mm512_store_si512((__m512i*)itBlock, count);
+		_mm512_store_pd(zrBlock, _mm512_mask_mov_pd(escapedZr, active, zr));
+		_mm512_store_pd(ziBlock, _mm512_mask_mov_pd(escapedZi, active, zi));
+		for (int lane = 0; lane < 8 && i + lane < _count; lane++)
+		{
+			_iterations[i + lane] = (interior >> lane) & 1 ? ITERATIONS_INTERIOR : (int)itBlock[lane];
+			total += itBlock[lane] - start;
+			_orbits[i + lane].zr = zrBlock[lane];
+			_orbits[i + lane].zi = ziBlock[lane];
+		}
+	}
+	return total;
+}
+
+template <bool Resume>
+long long kernelAvx512Double(const MclView& _view, const double* _px, const double* _py, int _count, int* _iterations, MclOrbitState* _orbits)
+{
+	return dispatchFractal(_view.fractal, [&](auto _formula, auto _power)
+	{
+		constexpr int Formula = decltype(_formula)::value, Power = decltype(_power)::value;
+		if (_view.interiorChecks) return kernelAvx512DoubleImpl<Formula, Power, true, Resume>(_view, _px, _py, _count, _iterations, _orbits);
+		else return kernelAvx512DoubleImpl<Formula, Power, false, Resume>(_view, _px, _py, _count, _iterations, _orbits);
+	});
+}
+
+/* AVX-512 kernel, 16 points per block in single precision */
+template <int Formula, int Power, bool InteriorChecks, bool Resume>
+MCL_TARGET_AVX512 long long kernelAvx512FloatImpl(const MclView& _view, const double* _px, const double* _py, int _count, int* _iterations, MclOrbitState* _orbits)
+{
+	alignas(64) float crBlock[16], ciBlock[16], zrBlock[16], ziBlock[16];
+	alignas(64) int itBlock[16];
+	const __m512 bailout = _mm512_set1_ps((float)BAILOUT_SQUARED), epsilon = _mm512_set1_ps((float)getPeriodicityEpsilon<float>(_view));
+	const __m512i one = _mm512_set1_epi32(1);
+	const int start = Resume ? _iterations[0] : 0;
+	long long total = 0;
+	for (int i = 0; i < _count; i += 16)
+	{
+		int interior = loadKernelBlock(_view, _px, _py, i, _count, 16, InteriorChecks && hasMainBulbs<Formula, Power>(), crBlock, ciBlock);
+		__m512 cr = _mm512_load_ps(crBlock), ci = _mm512_load_ps(ciBlock);
+		if (Resume) loadOrbitBlock(_orbits, i, _count, 16, zrBlock, ziBlock);
+		__m512 zr = Resume ? _mm512_load_ps(zrBlock) : _mm512_setzero_ps(), zi = Resume ? _mm512_load_ps(ziBlock) : _mm512_setzero_ps();
+		if constexpr (Formula == FORMULA_JULIA)
+		{
+			if (!Resume)
+			{
+				zr = cr;
+				zi = ci;
+			}
+			cr = _mm512_set1_ps((float)_view.fractal.juliaR);
+			ci = _mm512_set1_ps((float)_view.fractal.juliaI);
+		}
+		__m512 savedZr = zr, savedZi = zi, escapedZr = zr, escapedZi = zi;
+		__mmask16 active = (__mmask16)~interior;
+		__m512i count = _mm512_set1_epi32(start);
+		for (int iterations = start, checkpoint = 1; iterations < _view.maxIterations; ++iterations)
+		{
+			__m512 zr2 = _mm512_mul_ps(zr, zr), zi2 = _mm512_mul_ps(zi, zi);
+			__mmask16 inside = _mm512_mask_cmp_ps_mask(active, _mm512_add_ps(zr2, zi2), bailout, _CMP_LT_OQ);
+			escapedZr = _mm512_mask_mov_ps(escapedZr, active & ~inside, zr);
+			escapedZi = _mm512_mask_mov_ps(escapedZi, active & ~inside, zi);
+			active = inside;
+			if (active == 0) break;
+			count = _mm512_mask_add_epi32(count, active, count, one);
+			stepAvx512Float<Formula, Power>(zr, zi, zr2, zi2, cr, ci);
+
+			if (InteriorChecks)
+			{
+				__m512 dr = _mm512_sub_ps(zr, savedZr), di = _mm512_sub_ps(zi, savedZi);
+				__mmask16 periodic = _mm512_mask_cmp_ps_mask(active, _mm512_fmadd_ps(dr, dr, _mm512_mul_ps(di, di)), epsilon, _CMP_LT_OQ);
+				interior |= periodic;
+				active &= ~periodic;
+				if (iterations + 1 - start == checkpoint)
+				{
+					savedZr = zr;
+					savedZi = zi;
+					checkpoint *= 2;
+				}
+			}
+		}
+		_mm512_store_si512((__m512i*)itBlock, count);
+		_mm512_store_ps(zrBlock, _mm512_mask_mov_ps(escapedZr, active, zr));
+		_mm512_store_ps(ziBlock, _mm512_mask_mov_ps(escapedZi, active, zi));
+		for (int lane = 0; lane < 16 && i + lane < _count; lane++)
+		{
+			_iterations[i + lane] = (interior >> lane) & 1 ? ITERATIONS_INTERIOR : itBlock[lane];
+			total += itBlock[lane] - start;
+			_orbits[i + lane].zr = zrBlock[lane];
+			_orbits[i + lane].zi = ziBlock[lane];
+		}
+	}
+	return total;
+}
+
+template <bool Resume>
+long long kernelAvx512Float(const MclView& _view, const double* _px, const double* _py, int _count, int* _iterations, MclOrbitState* _orbits)
+{
+	return dispatchFractal(_view.fractal, [&](auto _formula, auto _power)
+	{
+		constexpr int Formula = decltype(_formula)::value, Power = decltype(_power)::value;
+		if (_view.interiorChecks) return kernelAvx512FloatImpl<Formula, Power, true, Resume>(_view, _px, _py, _count, _iterations, _orbits);
+		else return kernelAvx512FloatImpl<Formula, Power, false, Resume>(_view, _px, _py, _count, _iterations, _orbits);
+	});
+}
+
+/* Computes the orbit of the point at pixel (_px, _py) in arbitrary precision, using '_limbs' limbs */
+shared_ptr<MclReferenceOrbit> computeReferenceOrbit(const MclView& _view, double _px, double _py, int _limbs)
+{
+	shared_ptr<MclReferenceOrbit> orbit = make_shared<MclReferenceOrbit>();
+	orbit->px = _px;
+	orbit->py = _py;
+	MclBigFixed cr = toBigFixed(_view.exactLeft, _px, _view.pixelWidth), ci = toBigFixed(_view.exactTop, _py, _view.pixelHeight);
+	MclBigFixed zr(0.0), zi(0.0);
+	for (int n = 0; n <= _view.maxIterations; n++)
+	{
+		double zrDouble = toDouble(zr), ziDouble = toDouble(zi);
+		double magnitude = zrDouble * zrDouble + ziDouble * ziDouble;
+		orbit->zr.push_back(zrDouble);
+		orbit->zi.push_back(ziDouble);
+		orbit->glitchLimit.push_back(magnitude * GLITCH_TOLERANCE * GLITCH_TOLERANCE);
+		if (magnitude >= BAILOUT_SQUARED) break;
+
+		MclBigFixed zri = multiply(zr, zi, _limbs);
+		MclBigFixed zr2 = multiply(zr, zr, _limbs), zi2 = multiply(zi, zi, _limbs);
+		zi = zri + zri + ci;
+		zr = zr2 - zi2 + cr;
+	}
+	return orbit;
+}
+
+/* Iterates one pixel as the delta 'dz' from a reference orbit Z, with dz' = (2Z + dz)dz + dc.
+'_dcr'/'_dci' is the distance from the reference point. Returns ITERATIONS_GLITCHED when the
+delta has lost its precision, unless '_ignoreGlitches' is set. Adds the iterations it ran to '_iterationsRun' */
+template <bool InteriorChecks>
+int iteratePerturbation(const MclReferenceOrbit& _orbit, double _dcr, double _dci, int _maxIterations, double _periodicityEpsilon, bool _ignoreGlitches, long long& _iterationsRun)
+{
+	int last = (int)_orbit.zr.size() - 1;
+	double dzr = 0.0, dzi = 0.0;
+	double savedZr = 0.0, savedZi = 0.0;
+	for (int n = 0, checkpoint = 1; n < _maxIterations; n++)
+	{
+		// the reference escaped while this pixel did not, there is nothing left to perturb around
+		if (n > last) { _iterationsRun += n; return _ignoreGlitches ? n : ITERATIONS_GLITCHED; }
+
+		double zr = _orbit.zr[n] + dzr, zi = _orbit.zi[n] + dzi;
+		double magnitude = zr * zr + zi * zi;
+		if (magnitude >= BAILOUT_SQUARED) { _iterationsRun += n; return n; }
+		if (magnitude < _orbit.glitchLimit[n] && !_ignoreGlitches) { _iterationsRun += n; return ITERATIONS_GLITCHED; }
+
+		// periodicity checking on the full orbit z = Z + dz, as in 'kernelScalarImpl'
+		if (InteriorChecks && n > 0)
+		{
+			double dr = zr - savedZr, di = zi - savedZi;
+			if (dr * dr + di * di < _periodicityEpsilon) { _iterationsRun += n; return ITERATIONS_INTERIOR; }
+			if (n == checkpoint)
+			{
+				savedZr = zr;
+				savedZi = zi;
+				checkpoint *= 2;
+			}
+		}
+
+		double tr = 2.0 * _orbit.zr[n] + dzr, ti = 2.0 * _orbit.zi[n] + dzi;
+		double nextDzr = tr * dzr - ti * dzi + _dcr;
+		dzi = tr * dzi + ti * dzr + _dci;
+		dzr = nextDzr;
+	}
+	_iterationsRun += _maxIterations;
+	return _maxIterations;
+}
+
+/* Gets a reference orbit to retry a glitched pixel with. Reuses the secondary reference closest to the pixel
+unless it was already tried, otherwise computes a new reference at the pixel itself (which cannot glitch) */
+shared_ptr<MclReferenceOrbit> getSecondaryReference(const MclView& _view, double _px, double _py, const vector<MclReferenceOrbit*>& _tried)
+{
+	MclReferenceSet& references = *_view.references;
+	{
+		unique_lock<mutex> lk(references.secondaryMutex);
+		shared_ptr<MclReferenceOrbit> closest;
+		double closestDistance = 0.0;
+		for (const shared_ptr<MclReferenceOrbit>& orbit : references.secondary)
+		{
+			double distance = fabs(orbit->px - _px) + fabs(orbit->py - _py);
+			if (!closest || distance < closestDistance)
+			{
+				closest = orbit;
+				closestDistance = distance;
+			}
+		}
+		if (closest && std::find(_tried.begin(), _tried.end(), closest.get()) == _tried.end()) return closest;
+	}
+
+	shared_ptr<MclReferenceOrbit> orbit = computeReferenceOrbit(_view, _px, _py, references.limbs);
+	unique_lock<mutex> lk(references.secondaryMutex);
+	references.secondary.push_back(orbit);
+	return orbit;
+}
+
+/* Perturbation kernel for deep zooms. Every pixel is iterated in double as a delta from the frame's reference orbit,
+glitched pixels are retried against other references for up to MAX_REFERENCE_ROUNDS rounds */
+template <bool InteriorChecks>
+long long kernelPerturbationImpl(const MclView& _view, const double* _px, const double* _py, int _count, int* _iterations, MclOrbitState* _orbits)
+{
+	const double epsilon = getPeriodicityEpsilon<double>(_view);
+	long long total = 0;
+	vector<int> glitched;
+	const MclReferenceOrbit* orbit = _view.references->primary.get();
+	for (int i = 0; i < _count; i++)
+	{
+		if (InteriorChecks && isInMainBulbs(toPlane<double>(_view.left, _px[i], _view.pixelWidth), toPlane<double>(_view.top, _py[i], _view.pixelHeight)))
+		{
+			_iterations[i] = ITERATIONS_INTERIOR;
+			continue;
+		}
+		_iterations[i] = iteratePerturbation<InteriorChecks>(*orbit, (_px[i] - orbit->px) * _view.pixelWidth, (_py[i] - orbit->py) * _view.pixelHeight, _view.maxIterations, epsilon, false, total);
+		if (_iterations[i] == ITERATIONS_GLITCHED) glitched.push_back(i);
+	}
+
+	vector<MclReferenceOrbit*> tried;
+	for (int round = 0; !glitched.empty(); round++)
+	{
+		bool lastRound = round == MAX_REFERENCE_ROUNDS;
+		int pick = glitched[glitched.size() / 2];
+		shared_ptr<MclReferenceOrbit> secondary = getSecondaryReference(_view, _px[pick], _py[pick], tried);
+		tried.push_back(secondary.get());
+
+		vector<int> stillGlitched;
+		for (int i : glitched)
+		{
+			_iterations[i] = iteratePerturbation<InteriorChecks>(*secondary, (_px[i] - secondary->px) * _view.pixelWidth, (_py[i] - secondary->py) * _view.pixelHeight, _view.maxIterations, epsilon, lastRound, total);
+			if (_iterations[i] == ITERATIONS_GLITCHED) stillGlitched.push_back(i);
+		}
+		glitched.swap(stillGlitched);
+	}
+	return total;
+}
+
+long long kernelPerturbation(const MclView& _view, const double* _px, const double* _py, int _count, int* _iterations, MclOrbitState* _orbits)
+{
+	if (!_view.references) return kernelScalar<MclDoubleDouble>(_view, _px, _py, _count, _iterations, _orbits);
+	else if (_view.interiorChecks) return kernelPerturbationImpl<true>(_view, _px, _py, _count, _iterations, _orbits);
+	else return kernelPerturbationImpl<false>(_view, _px, _py, _count, _iterations, _orbits);
+}
+
+/* Limbs the reference orbits need for a view. Enough to resolve single pixels with two limbs to spare,
+and never less than three fraction limbs so the orbit is at least as precise as the double deltas */
+int getReferenceLimbs(const MclView& _view)
+{
+	double spacing = std::min(fabs(_view.pixelWidth), fabs(_view.pixelHeight));
+	int fractionLimbs = std::max(3, (int)ceil(-log2(spacing) / 32.0) + 2);
+	return std::min(BIGFIXED_LIMBS, 1 + fractionLimbs);
+}
+
+/* Computes the primary reference orbit (at the centre of the view) for a frame of the perturbation kernel */
+shared_ptr<MclReferenceSet> createReferenceSet(const MclView& _view)
+{
+	shared_ptr<MclReferenceSet> references = make_shared<MclReferenceSet>();
+	references->limbs = getReferenceLimbs(_view);
+	references->primary = computeReferenceOrbit(_view, _view.width / 2, _view.height / 2, references->limbs);
+	return references;
+}
+
+// every kernel, grouped by precision. Within a precision the fastest kernel is listed last
+const MclKernelInfo kernelArray[] =
+{
+	{ "scalar float", kernelScalar<float>, kernelScalar<float, true>, CPU_SCALAR, PRECISION_FLOAT },
+	{ "AVX2 float (8 lanes)", kernelAvx2Float<false>, kernelAvx2Float<true>, CPU_AVX2, PRECISION_FLOAT },
+	{ "AVX-512 float (16 lanes)", kernelAvx512Float<false>, kernelAvx512Float<true>, CPU_AVX512, PRECISION_FLOAT },
+	{ "scalar double", kernelScalar<double>, kernelScalar<double, true>, CPU_SCALAR, PRECISION_DOUBLE },
+	{ "AVX2 double (4 lanes)", kernelAvx2Double<false>, kernelAvx2Double<true>, CPU_AVX2, PRECISION_DOUBLE },
+	{ "AVX-512 double (8 lanes)", kernelAvx512Double<false>, kernelAvx512Double<true>, CPU_AVX512, PRECISION_DOUBLE },
+#if LDBL_MANT_DIG > DBL_MANT_DIG
+	// only worth having where long double is wider than double (it is the same type on MSVC)
+	{ "scalar long double", kernelScalar<long double>, nullptr, CPU_SCALAR, PRECISION_LONG_DOUBLE },
+#endif
+	{ "scalar double-double", kernelScalar<MclDoubleDouble>, nullptr, CPU_SCALAR, PRECISION_DOUBLE_DOUBLE },
+	{ "scalar perturbation", kernelPerturbation, nullptr, CPU_SCALAR, PRECISION_PERTURBATION }
+};
+const int KERNEL_COUNT = sizeof(kernelArray) / sizeof(kernelArray[0]);
+
+/* Finds the highest instruction set extension supported by both the CPU and the OS */
+MclCpuFeature detectCpuFeature()
+{
+#ifdef _MSC_VER
+	int regs[4];
+	__cpuid(regs, 1);
+	bool osxsave = (regs[2] & (1 << 27)) != 0, avx = (regs[2] & (1 << 28)) != 0, fma = (regs[2] & (1 << 12)) != 0;
+	if (!osxsave || !avx) return CPU_SCALAR;
+	unsigned long long xcr0 = _xgetbv(0);
+	if ((xcr0 & 0x6) != 0x6) return CPU_SCALAR; // OS does not save the YMM registers
+	__cpuidex(regs, 7, 0);
+	bool avx2 = (regs[1] & (1 << 5)) != 0, avx512f = (regs[1] & (1 << 16)) != 0;
+	if (avx512f && (xcr0 & 0xE6) == 0xE6) return CPU_AVX512;
+	if (avx2 && fma) return CPU_AVX2;
+	return CPU_SCALAR;
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) return CPU_AVX512;
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return CPU_AVX2;
+	return CPU_SCALAR;
+#endif
+}
+
+/* Can the given kernel run on this CPU? */
+bool isKernelSupported(int _kernelIndex)
+{
+	return kernelArray[_kernelIndex].requires <= cpuFeature;
+}
+
+/* Number of mantissa bits of each precision */
+int getPrecisionBits(MclPrecision _precision)
+{
+	switch (_precision)
+	{
+	case PRECISION_FLOAT: return FLT_MANT_DIG;
+	case PRECISION_DOUBLE: return DBL_MANT_DIG;
+	case PRECISION_LONG_DOUBLE: return LDBL_MANT_DIG;
+	case PRECISION_DOUBLE_DOUBLE: return 2 * DBL_MANT_DIG;
+	default: return 32 * (BIGFIXED_LIMBS - 1);
+	}
+}
+
+/* Chooses the cheapest precision which can still tell neighbouring pixels of the view apart */
+MclPrecision getRequiredPrecision(const MclView& _view)
+{
+	// the orbit of every point still inside the bailout stays within |z| < 2, so that bounds the exponent as well
+	double magnitude = std::max({ 2.0, fabs(_view.left.hi), fabs(_view.left.hi + _view.width * _view.pixelWidth),
+		fabs(_view.top.hi), fabs(_view.top.hi + _view.height * _view.pixelHeight) });
+	double spacing = std::min(fabs(_view.pixelWidth), fabs(_view.pixelHeight));
+	double bitsNeeded = log2(magnitude / spacing) + PRECISION_GUARD_BITS;
+
+	for (int precision = PRECISION_FLOAT; precision < PRECISION_PERTURBATION; precision++)
+	{
+		if (bitsNeeded <= getPrecisionBits((MclPrecision)precision)) return (MclPrecision)precision;
+	}
+	return PRECISION_PERTURBATION;
+}
+
+/* Finds the fastest supported kernel with at least the given precision */
+int findKernel(MclPrecision _precision)
+{
+	for (int precision = _precision; precision <= PRECISION_PERTURBATION; precision++)
+	{
+		int found = -1;
+		for (int i = 0; i < KERNEL_COUNT; i++)
+		{
+			if (isKernelSupported(i) && kernelArray[i].precision == precision) found = i;
+		}
+		if (found != -1) return found;
+	}
+	return KERNEL_COUNT - 1;
+}
+
+/* Gets the kernel to compute a view with. Unless a kernel was picked with the K key, this is
+the fastest kernel which is precise enough for the zoom depth of the view. Past double precision
+that is the perturbation kernel, unless it was turned off with the P key. The perturbation kernel only
+computes the quadratic Mandelbrot set, the other fractals go no deeper than double-double */
+int getKernelForView(const MclView& _view)
+{
+	int selected = kernelIndex;
+	bool quadratic = isQuadraticMandelbrot(_view.fractal);
+	if (selected != -1 && (quadratic || kernelArray[selected].precision != PRECISION_PERTURBATION)) return selected;
+	MclPrecision precision = getRequiredPrecision(_view);
+	if (precision > PRECISION_DOUBLE && preferPerturbation) precision = PRECISION_PERTURBATION;
+	if (!quadratic) precision = std::min(precision, PRECISION_DOUBLE_DOUBLE);
+	return findKernel(precision);
+}
+
+/* Gets the iteration limit to compute a view with. This is the limit set with the Page Up / Page Down keys, raised by
+ADAPTIVE_ITERATIONS_PER_OCTAVE for every doubling of the zoom past the default view when 'adaptiveIterations = true' */
+int getMaxIterations(const MclView& _view)
+{
+	int limit = maxIterations;
+	const double defaultWidth = 3.0; // see 'resetZoom'
+	double octaves = log2(defaultWidth / fabs(_view.width * _view.pixelWidth));
+	if (adaptiveIterations && octaves > 0.0) limit += (int)(ADAPTIVE_ITERATIONS_PER_OCTAVE * octaves);
+	return std::min(limit, MAX_MAX_ITERATIONS);
+}
+
+/*** ~ FUNCTIONS ~ ***/
+
+/* Gets the number of columns and rows of tiles needed to cover a frame of the view (the last ones may be cut short) */
+inline int getTileColumns(const MclView& _view)
+{
+	return (_view.width + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+inline int getTileRows(const MclView& _view)
+{
+	return (_view.height + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+inline int getTileCount(const MclView& _view)
+{
+	return getTileColumns(_view) * getTileRows(_view);
+}
+
+/* Gets id of the tile of a frame of the view which contains the pixel (_x, _y) */
+int getTileId(const MclView& _view, int _x, int _y)
+{
+	return (_y / TILE_SIZE) * getTileColumns(_view) + _x / TILE_SIZE;
+}
+
+/* Gets the pixels covered by a tile of a frame of the view */
+void getTileBounds(const MclView& _view, int _tileId, int& _startX, int& _endX, int& _startY, int& _endY)
+{
+	_startX = (_tileId % getTileColumns(_view)) * TILE_SIZE;
+	_startY = (_tileId / getTileColumns(_view)) * TILE_SIZE;
+	_endX = std::min(_startX + TILE_SIZE, _view.width);
+	_endY = std::min(_startY + TILE_SIZE, _view.height);
+}
+
+/* Gets the stamp published for a tile finished up to the pass with step '_step' of frame '_epoch' */
+inline uint32_t getTileStamp(uint32_t _epoch, int _step)
+{
+	return (_epoch << TILE_STAMP_STEP_BITS) | _step;
+}
+
+/* Is the tile with stamp '_stamp' finished at full resolution for frame '_epoch', anti-aliased or not? */
+inline bool isTileFinished(uint32_t _stamp, uint32_t _epoch)
+{
+	return _stamp == getTileStamp(_epoch, 1) || _stamp == getTileStamp(_epoch, TILE_STEP_ANTIALIASED);
+}
+
+/* Gets the frame of a tile stamp */
+inline uint32_t getStampEpoch(uint32_t _stamp)
+{
+	return _stamp >> TILE_STAMP_STEP_BITS;
+}
+
+/* Gets the step of the pass of a tile stamp */
+inline int getStampStep(uint32_t _stamp)
+{
+	return _stamp & ((1 << TILE_STAMP_STEP_BITS) - 1);
+}
+
+/* Tells the rendering thread there may be something new to show, and wakes it up if it sleeps in 'glfwWaitEventsTimeout'.
+Only the first call since it last looked posts an event. Can be called from any thread */
+inline void damageDisplay()
+{
+	if (!displayDamaged.exchange(true)) glfwPostEmptyEvent();
+}
+
+/* Has the view or a setting changed since the view of generation '_generation' was taken? */
+inline bool isStale(uint32_t _generation)
+{
+	return viewGeneration.load(std::memory_order_relaxed) != _generation;
+}
+
+/* Waits until the back buffer tile can be written for frame '_epoch'. Any number of jobs of one frame can write a tile
+at once (the rectangles of a subdivided tile), but not together with the jobs of an older frame, which may still be
+finishing a sample batch when the next frame starts. Those notice that they are stale after at most one batch, so this only
+spins briefly. Each call must be paired with 'leaveTile' */
+void enterTile(int _tileId, uint32_t _epoch)
+{
+	std::atomic<uint64_t>& writers = tileWriterArray[_tileId];
+	uint64_t state = writers.load(std::memory_order_relaxed);
+	while (true)
+	{
+		if ((uint32_t)state != 0 && state >> 32 != _epoch)
+		{
+			std::this_thread::yield();
+			state = writers.load(std::memory_order_relaxed);
+		}
+		else if (writers.compare_exchange_weak(state, ((uint64_t)_epoch << 32) | ((uint32_t)state + 1), std::memory_order_acquire)) return;
+	}
+}
+
+/* Ends writing a tile, see 'enterTile' */
+inline void leaveTile(int _tileId)
+{
+	tileWriterArray[_tileId].fetch_sub(1, std::memory_order_release);
+}
+
+/* Gets the fraction of an iteration past '_iterations' at which a pixel escaped, from the z it escaped with. The orbit is
+continued in double precision until |z|^2 passes SMOOTH_BAILOUT_SQUARED, where the normalized iteration count
+'iterations - log_p(log2 |z|)' for power p is close to continuous. The result is offset so that it escapes at 0 at
+exactly that radius. Returns 0 for pixels which did not escape, or whose kernel does not store orbits (they are NaN) */
+float getEscapeFraction(const MclView& _view, double _px, double _py, int _iterations, const MclOrbitState& _orbit)
+{
+	if (_iterations < 0 || _iterations >= _view.maxIterations || std::isnan(_orbit.zr)) return 0.0f;
+	double cr = _view.left.hi + _px * _view.pixelWidth, ci = _view.top.hi + _py * _view.pixelHeight;
+	if (_view.fractal.formula == FORMULA_JULIA)
+	{
+		cr = _view.fractal.juliaR;
+		ci = _view.fractal.juliaI;
+	}
+	double zr = _orbit.zr, zi = _orbit.zi, zr2 = zr * zr, zi2 = zi * zi;
+	int extra = 0;
+	dispatchFractal(_view.fractal, [&](auto _formula, auto _power)
+	{
+		while (zr2 + zi2 < SMOOTH_BAILOUT_SQUARED && extra < 64)
+		{
+			stepFormula<decltype(_formula)::value, decltype(_power)::value>(zr, zi, zr2, zi2, cr, ci);
+			zr2 = zr * zr;
+			zi2 = zi * zi;
+			extra++;
+		}
+	});
+	const double radius = log2(0.5 * log2(SMOOTH_BAILOUT_SQUARED));
+	return (float)(extra + (radius - log2(0.5 * log2(zr2 + zi2))) / log2((double)_view.fractal.power));
+}
+
+/* Runs the kernel over the pixels of a batch, stores the iteration counts and escape fractions in the back buffer
+and empties the batch. Counts the iterations and the results in the worker's 'workerStatsArray' entry */
+void flushSamples(MclSampleBatch& _batch)
+{
+	if (_batch.count == 0) return;
+	int iterations[SAMPLE_BATCH_SIZE];
+	MclOrbitState orbits[SAMPLE_BATCH_SIZE];
+	for (int i = 0; i < _batch.count; ++i)
+	{
+		if (_batch.resumeFrom == 0)
+		{
+			// kernels past double precision leave the orbits alone
+			orbits[i].zr = std::numeric_limits<double>::quiet_NaN();
+			continue;
+		}
+		iterations[i] = _batch.resumeFrom;
+		orbits[i] = orbitPixels.row((int)_batch.py[i])[(int)_batch.px[i]];
+	}
+	MclWorkerStats& stats = workerStatsArray[_batch.workerId];
+	stats.iterations += _batch.kernel(*_batch.view, _batch.px, _batch.py, _batch.count, iterations, orbits);
+	for (int i = 0; i < _batch.count; ++i)
+	{
+		int x = (int)_batch.px[i], y = (int)_batch.py[i];
+		*_batch.targets[i] = iterations[i];
+		orbitPixels.row(y)[x] = orbits[i];
+		fractionPixels.row(y)[x] = getEscapeFraction(*_batch.view, _batch.px[i], _batch.py[i], iterations[i], orbits[i]);
+		if (iterations[i] == ITERATIONS_INTERIOR) stats.interiorPixels++;
+		else if (iterations[i] >= _batch.view->maxIterations) stats.limitPixels++;
+		else stats.escapedPixels++;
+	}
+	_batch.count = 0;
+}
+
+/* Adds the pixels of a rectangle to a batch, running the kernel each time it fills up. Only pixels whose coordinates
+are multiples of '_step' are added, and with '_refine' the ones which are also multiples of twice the step are
+skipped, as the previous pass has them already. If the view went stale it will stop and return false */
+bool addSamples(MclSampleBatch& _batch, int _startX, int _endX, int _startY, int _endY, int _step, bool _refine)
+{
+	for (int y = _startY; y < _endY; y += _step)
+	{
+		bool coarseRow = _refine && y % (2 * _step) == 0;
+		for (int x = _startX; x < _endX; x += _step)
+		{
+			if (coarseRow && x % (2 * _step) == 0) continue;
+			_batch.px[_batch.count] = x;
+			_batch.py[_batch.count] = y;
+			_batch.targets[_batch.count] = pixels.row(y) + x;
+			if (++_batch.count < SAMPLE_BATCH_SIZE) continue;
+
+			if (isStale(_batch.view->generation)) return false;
+			flushSamples(_batch);
+		}
+	}
+	return true;
+}
+
+/* compute the mandlebrot set given zoom values and a tile of the screen, SAMPLE_BATCH_SIZE pixels per kernel call.
+See 'addSamples' for '_step' and '_refine'. Iteration counts are stored in the back buffer.
+If the view went stale computation will stop and false is returned */
+bool computeMandelbrot(MclKernel _kernel, const MclView& _view, int _startX, int _endX, int _startY, int _endY, int _step, bool _refine, int _workerId)
+{
+	try
+	{
+		MclSampleBatch batch(_kernel, _view, _workerId);
+		if (!addSamples(batch, _startX, _endX, _startY, _endY, _step, _refine) || isStale(_view.generation)) return false;
+		flushSamples(batch);
+		return true;
+	}
+	catch (const exception& e) { cout << "ERROR (computeMandelbrot)\n" << e.what() << endl; }
+	return false;
+}
+
+/* Continues the pixels of a rectangle of the back buffer which reached the iteration limit '_previousMaxIterations'
+of the last frame up to the limit of '_view', with the resume variant of the kernel the last frame used and the orbits
+kept in 'orbitPixels'. The last frame must have had the same view. If the view went stale computation will stop
+and false is returned */
+bool resumeMandelbrot(MclKernel _kernel, const MclView& _view, int _startX, int _endX, int _startY, int _endY, int _previousMaxIterations, int _workerId)
+{
+	try
+	{
+		MclSampleBatch batch(_kernel, _view, _workerId);
+		batch.resumeFrom = _previousMaxIterations;
+		for (int y = _startY; y < _endY; y++)
+		{
+			uint32_t* row = pixels.row(y);
+			for (int x = _startX; x < _endX; x++)
+			{
+				if (row[x] != (uint32_t)_previousMaxIterations) continue;
+				batch.px[batch.count] = x;
+				batch.py[batch.count] = y;
+				batch.targets[batch.count] = row + x;
+				if (++batch.count < SAMPLE_BATCH_SIZE) continue;
+
+				if (isStale(_view.generation)) return false;
+				flushSamples(batch);
+			}
+		}
+		if (isStale(_view.generation)) return false;
+		flushSamples(batch);
+		return true;
+	}
+	catch (const exception& e) { cout << "ERROR (resumeMandelbrot)\n" << e.what() << endl; }
+	return false;
+}
+
+void submitJob(int _workerId, const MclJob& _job, bool _front = false);
+
+/* Mariani-Silver subdivision of a job's rectangle. The border of the rectangle is computed (unless it is known from
+the rectangle it was split off) and if every border pixel has the same iteration count the inside is filled with it.
+Otherwise the rectangle is cut in four along a computed cross, and the quarters are queued at the front of the
+worker's own queue, where idle workers can steal them. Returns false if the view went stale */
+bool subdivideRectangle(const MclJob& _job, int _workerId)
+{
+	try
+	{
+		int x0 = _job.startX, x1 = _job.endX, y0 = _job.startY, y1 = _job.endY;
+		if (x1 - x0 < SUBDIVIDE_MIN_SIZE || y1 - y0 < SUBDIVIDE_MIN_SIZE)
+		{
+			if (!_job.subRectangle) return computeMandelbrot(_job.kernel, _job.view, x0, x1, y0, y1, 1, false, _workerId);
+			return computeMandelbrot(_job.kernel, _job.view, x0 + 1, x1 - 1, y0 + 1, y1 - 1, 1, false, _workerId);
+		}
+
+		MclSampleBatch batch(_job.kernel, _job.view, _workerId);
+		if (!_job.subRectangle)
+		{
+			if (!addSamples(batch, x0, x1, y0, y0 + 1, 1, false) || !addSamples(batch, x0, x1, y1 - 1, y1, 1, false)) return false;
+			if (!addSamples(batch, x0, x0 + 1, y0 + 1, y1 - 1, 1, false) || !addSamples(batch, x1 - 1, x1, y0 + 1, y1 - 1, 1, false)) return false;
+			if (isStale(_job.view.generation)) return false;
+			flushSamples(batch);
+		}
+
+		// fill the inside if the border is uniform
+		uint32_t value = pixels.row(y0)[x0];
+		bool uniform = true;
+		for (int x = x0; x < x1 && uniform; x++) uniform = pixels.row(y0)[x] == value && pixels.row(y1 - 1)[x] == value;
+		for (int y = y0 + 1; y < y1 - 1 && uniform; y++) uniform = pixels.row(y)[x0] == value && pixels.row(y)[x1 - 1] == value;
+		if (uniform)
+		{
+			// the inside has no escape fractions, it takes the one of the corner
+			float fraction = fractionPixels.row(y0)[x0];
+			for (int y = y0 + 1; y < y1 - 1; y++)
+			{
+				std::fill(pixels.row(y) + x0 + 1, pixels.row(y) + x1 - 1, value);
+				std::fill(fractionPixels.row(y) + x0 + 1, fractionPixels.row(y) + x1 - 1, fraction);
+			}
+			workerStatsArray[_workerId].filledPixels += (long long)(x1 - x0 - 2) * (y1 - y0 - 2);
+			return true;
+		}
+
+		// compute the cross and split along it
+		int midX = (x0 + x1) / 2, midY = (y0 + y1) / 2;
+		if (!addSamples(batch, midX, midX + 1, y0 + 1, y1 - 1, 1, false) || !addSamples(batch, x0 + 1, midX, midY, midY + 1, 1, false)) return false;
+		if (!addSamples(batch, midX + 1, x1 - 1, midY, midY + 1, 1, false) || isStale(_job.view.generation)) return false;
+		flushSamples(batch);
+
+		int tileId = getTileId(_job.view, x0, y0);
+		tileRemainingJobs[tileId] += 4;
+		int bounds[4][4] = { { x0, midX + 1, y0, midY + 1 }, { midX, x1, y0, midY + 1 }, { x0, midX + 1, midY, y1 }, { midX, x1, midY, y1 } };
+		for (int i = 0; i < 4; i++)
+		{
+			MclJob quarter(_job.kernel, _job.view, _job.epoch, bounds[i][0], bounds[i][1], bounds[i][2], bounds[i][3]);
+			quarter.subdivide = true;
+			quarter.subRectangle = true;
+			submitJob(_workerId, quarter, true);
+		}
+		return true;
+	}
+	catch (const exception& e) { cout << "ERROR (subdivideRectangle)\n" << e.what() << endl; }
+	return false;
+}
+
+/* How different two samples look: FLT_MAX if only one of them is in the set, otherwise the difference of their smooth
+iteration counts, 0 if both are in the set */
+inline float getSampleContrast(uint32_t _a, float _fractionA, uint32_t _b, float _fractionB, int _maxIterations)
+{
+	bool insideA = _a >= (uint32_t)_maxIterations, insideB = _b >= (uint32_t)_maxIterations;
+	if (insideA || insideB) return insideA == insideB ? 0.0f : FLT_MAX;
+	return fabsf((float)_a + _fractionA - (float)_b - _fractionB);
+}
+
+/* Gets the position of extra sample '_sample' of pixel '_x', '_y', relative to its base sample. The pixel is split into
+4 x 4 cells centred on the base sample, which lies in cell (2, 2). The first AA_FIRST_SAMPLES samples take one cell in
+each of the other quarters, the rest the remaining cells. Each sample is jittered within its cell by a hash of the pixel,
+so the pattern does not repeat from pixel to pixel, but the same pixel always gets the same samples */
+void getSampleOffset(int _x, int _y, int _sample, double& _dx, double& _dy)
+{
+	static const int cells[AA_EXTRA_SAMPLES][2] = { { 0, 0 }, { 2, 0 }, { 0, 2 }, { 1, 0 }, { 3, 0 }, { 0, 1 }, { 1, 1 }, { 2, 1 }, { 3, 1 }, { 1, 2 }, { 3, 2 }, { 0, 3 }, { 1, 3 }, { 2, 3 }, { 3, 3 } };
+	uint32_t hash = (uint32_t)_x * 0x9E3779B1u ^ (uint32_t)_y * 0x85EBCA77u ^ (uint32_t)_sample * 0xC2B2AE3Du;
+	hash = (hash ^ (hash >> 15)) * 0x2C1B3C6Du;
+	hash = (hash ^ (hash >> 12)) * 0x297A2D39u;
+	hash ^= hash >> 15;
+	_dx = ((double)cells[_sample][0] + (hash & 0xFFFF) / 65536.0) / 4.0 - 0.5;
+	_dy = ((double)cells[_sample][1] + (hash >> 16) / 65536.0) / 4.0 - 0.5;
+}
+
+/* Anti-aliases the edges of a tile of the back buffer which is finished at full resolution, as is the rest of the frame.
+Every pixel which differs from one of its 8 neighbours by more than AA_EDGE_THRESHOLD is an edge. Starting from the most
+different ones, the edges first get AA_FIRST_SAMPLES extra samples, and only those whose samples still differ get the rest
+of AA_EXTRA_SAMPLES. The tile takes AA_TILE_SAMPLES at most, half of them for the first samples. The samples of a
+pixel go to 'tileSampleArray' one after the other, and are run through the kernel SAMPLE_BATCH_SIZE at a time.
+The pixels themselves are left alone. Returns false if the view went stale */
+bool antialiasTile(const MclJob& _job, int _workerId)
+{
+	try
+	{
+		const MclView& view = _job.view;
+		int tileId = getTileId(view, _job.startX, _job.startY);
+		int tileWidth = _job.endX - _job.startX;
+
+		// find the edges, most different first
+		vector<std::pair<float, int>> edges;
+		for (int y = _job.startY; y < _job.endY; y++)
+		{
+			for (int x = _job.startX; x < _job.endX; x++)
+			{
+				uint32_t value = pixels.row(y)[x];
+				float fraction = fractionPixels.row(y)[x], contrast = 0.0f;
+				for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, view.height - 1); ny++)
+				{
+					for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, view.width - 1); nx++)
+					{
+						contrast = std::max(contrast, getSampleContrast(value, fraction, pixels.row(ny)[nx], fractionPixels.row(ny)[nx], view.maxIterations));
+					}
+				}
+				if (contrast > AA_EDGE_THRESHOLD) edges.push_back(std::make_pair(contrast, (y - _job.startY) * tileWidth + x - _job.startX));
+			}
+		}
+		std::sort(edges.begin(), edges.end(), [](const std::pair<float, int>& _a, const std::pair<float, int>& _b) { return _a.first > _b.first; });
+		int edgeCount = std::min((int)edges.size(), AA_TILE_SAMPLES / 2 / AA_FIRST_SAMPLES);
+
+		// runs the kernel over the samples collected so far, keeping the results in 'samples'
+		vector<MclAaSample> samples((size_t)edgeCount * AA_EXTRA_SAMPLES);
+		double px[SAMPLE_BATCH_SIZE], py[SAMPLE_BATCH_SIZE];
+		int iterations[SAMPLE_BATCH_SIZE];
+		MclOrbitState orbits[SAMPLE_BATCH_SIZE];
+		MclAaSample* targets[SAMPLE_BATCH_SIZE];
+		int count = 0;
+		MclWorkerStats& stats = workerStatsArray[_workerId];
+		auto flush = [&]
+		{
+			if (count == 0) return true;
+			if (isStale(view.generation)) return false;
+			stats.iterations += _job.kernel(view, px, py, count, iterations, orbits);
+			for (int i = 0; i < count; i++)
+			{
+				targets[i]->iterations = iterations[i];
+				targets[i]->fraction = getEscapeFraction(view, px[i], py[i], iterations[i], orbits[i]);
+			}
+			stats.extraSamples += count;
+			count = 0;
+			return true;
+		};
+		auto addSample = [&](int _edge, int _sample)
+		{
+			int pixel = edges[_edge].second, x = _job.startX + pixel % tileWidth, y = _job.startY + pixel / tileWidth;
+			double dx, dy;
+			getSampleOffset(x, y, _sample, dx, dy);
+			px[count] = x + dx;
+			py[count] = y + dy;
+			orbits[count].zr = std::numeric_limits<double>::quiet_NaN();
+			targets[count] = &samples[(size_t)_edge * AA_EXTRA_SAMPLES + _sample];
+			targets[count]->pixel = (uint16_t)pixel;
+			return ++count < SAMPLE_BATCH_SIZE || flush();
+		};
+
+		// the first samples of every edge, then the rest for the edges whose samples differ while the budget lasts
+		for (int edge = 0; edge < edgeCount; edge++) for (int sample = 0; sample < AA_FIRST_SAMPLES; sample++) if (!addSample(edge, sample)) return false;
+		if (!flush()) return false;
+		vector<int> sampleCounts(edgeCount, AA_FIRST_SAMPLES);
+		int budget = AA_TILE_SAMPLES - edgeCount * AA_FIRST_SAMPLES;
+		for (int edge = 0; edge < edgeCount && budget >= AA_EXTRA_SAMPLES - AA_FIRST_SAMPLES; edge++)
+		{
+			int pixel = edges[edge].second, x = _job.startX + pixel % tileWidth, y = _job.startY + pixel / tileWidth;
+			const MclAaSample* first = &samples[(size_t)edge * AA_EXTRA_SAMPLES];
+			bool uniform = true;
+			for (int i = 0; i < AA_FIRST_SAMPLES && uniform; i++)
+			{
+				uniform = getSampleContrast(pixels.row(y)[x], fractionPixels.row(y)[x], first[i].iterations, first[i].fraction, view.maxIterations) <= AA_EDGE_THRESHOLD;
+				for (int j = i + 1; j < AA_FIRST_SAMPLES && uniform; j++) uniform = getSampleContrast(first[i].iterations, first[i].fraction, first[j].iterations, first[j].fraction, view.maxIterations) <= AA_EDGE_THRESHOLD;
+			}
+			if (uniform) continue;
+			for (int sample = AA_FIRST_SAMPLES; sample < AA_EXTRA_SAMPLES; sample++) if (!addSample(edge, sample)) return false;
+			sampleCounts[edge] = AA_EXTRA_SAMPLES;
+			budget -= AA_EXTRA_SAMPLES - AA_FIRST_SAMPLES;
+		}
+		if (!flush()) return false;
+
+		// hand them to the tile, the samples of each pixel next to each other
+		MclAaSample* tileSamples = &tileSampleArray[(size_t)tileId * AA_TILE_SAMPLES];
+		int used = 0;
+		for (int edge = 0; edge < edgeCount; edge++)
+		{
+			memcpy(tileSamples + used, &samples[(size_t)edge * AA_EXTRA_SAMPLES], sizeof(MclAaSample) * sampleCounts[edge]);
+			used += sampleCounts[edge];
+		}
+		tileSampleCounts[tileId] = used;
+		stats.antialiasedPixels += edgeCount;
+		return true;
+	}
+	catch (const exception& e) { cout << "ERROR (antialiasTile)\n" << e.what() << endl; }
+	return false;
+}
+
+MclTileKey getTileKey(const MclView& _view, int _kernelIndex, int _tileId);
+uint64_t hashTileKey(const MclTileKey& _key);
+
+/* Has the view changed, or the cursor moved, since the speculative job '_job' was made? */
+inline bool isPrefetchStale(const MclJob& _job)
+{
+	return isStale(_job.view.generation) || hoverGeneration.load(std::memory_order_relaxed) != _job.hoverGeneration;
+}
+
+/* Computes the tile of a speculative job into a tile of its own, and hands it to the main thread for the cache
+through 'prefetchedTiles'. The back buffer is left alone, as is the worker's 'workerStatsArray' entry.
+Stops at the next batch of SAMPLE_BATCH_SIZE pixels once the job is stale */
+void prefetchTile(const MclJob& _job)
+{
+	try
+	{
+		MclTileCacheEntry tile;
+		tile.key = getTileKey(_job.view, _job.prefetchKernelIndex, getTileId(_job.view, _job.startX, _job.startY));
+		tile.hash = hashTileKey(tile.key);
+		tile.iterations.resize((size_t)tile.key.width * tile.key.height);
+		tile.fractions.resize(tile.iterations.size());
+
+		double px[SAMPLE_BATCH_SIZE], py[SAMPLE_BATCH_SIZE];
+		int iterations[SAMPLE_BATCH_SIZE];
+		MclOrbitState orbits[SAMPLE_BATCH_SIZE];
+		int count = 0, done = 0;
+		for (int y = _job.startY; y < _job.endY; y++)
+		{
+			for (int x = _job.startX; x < _job.endX; x++)
+			{
+				px[count] = x;
+				py[count] = y;
+				orbits[count].zr = std::numeric_limits<double>::quiet_NaN();
+				if (++count < SAMPLE_BATCH_SIZE && (y < _job.endY - 1 || x < _job.endX - 1)) continue;
+
+				if (isPrefetchStale(_job)) return;
+				_job.kernel(_job.view, px, py, count, iterations, orbits);
+				for (int i = 0; i < count; i++, done++)
+				{
+					tile.iterations[done] = iterations[i];
+					tile.fractions[done] = getEscapeFraction(_job.view, px[i], py[i], iterations[i], orbits[i]);
+				}
+				count = 0;
+			}
+		}
+
+		unique_lock<mutex> lk(prefetchMutex);
+		prefetchedTiles.push_back(std::move(tile));
+	}
+	catch (const exception& e) { cout << "ERROR (prefetchTile)\n" << e.what() << endl; }
+}
+
+/* Computes a job into the back buffer and publishes its tile to the rendering thread once it is complete.
+The tile is marked TILE_WRITING by the job which starts it, so the rendering thread can tell when a copy it made
+was torn. A subdivided tile is complete when the last of its rectangles finishes. The time the job took is
+added to the worker's busy time and to the cost of the tile before it is published, and recorded for a trace.
+Jobs of a stale view are dropped, once they could get at the tile too, as it may belong to the next frame by then */
+void computeTile(const MclJob& _job, int _workerId)
+{
+	if (_job.prefetchKernelIndex >= 0)
+	{
+		if (!isPrefetchStale(_job)) prefetchTile(_job);
+		return;
+	}
+	if (isStale(_job.view.generation)) return;
+	timer::time_point start = timer::now();
+	int tileId = getTileId(_job.view, _job.startX, _job.startY);
+	enterTile(tileId, _job.epoch);
+	if (isStale(_job.view.generation))
+	{
+		leaveTile(tileId);
+		return;
+	}
+	MclWorkerStats& stats = workerStatsArray[_workerId];
+	if (stats.epoch != _job.epoch)
+	{
+		stats.busyMicroseconds = stats.iterations = 0;
+		stats.escapedPixels = stats.limitPixels = stats.interiorPixels = stats.filledPixels = 0;
+		stats.antialiasedPixels = stats.extraSamples = 0;
+		stats.epoch = _job.epoch;
+	}
+
+	std::atomic<uint32_t>& tileStamp = tileStampArray[tileId];
+	if (!_job.subRectangle)
+	{
+		tileStamp.store(TILE_WRITING, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		tileRemainingJobs[tileId] = 1;
+	}
+
+	bool finished = _job.antialias ? antialiasTile(_job, _workerId) : _job.resumeFrom > 0 ? resumeMandelbrot(_job.kernel, _job.view, _job.startX, _job.endX, _job.startY, _job.endY, _job.resumeFrom, _workerId)
+		: _job.subdivide ? subdivideRectangle(_job, _workerId) : computeMandelbrot(_job.kernel, _job.view, _job.startX, _job.endX, _job.startY, _job.endY, _job.step, _job.refine, _workerId);
+
+	timer::time_point end = timer::now();
+	long long duration = duration_cast<microseconds>(end - start).count();
+	stats.busyMicroseconds += duration;
+	if (_job.epoch == frameEpoch) tileCostArray[tileId].fetch_add((int)duration, std::memory_order_relaxed);
+	if (traceRecording)
+	{
+		MclTraceEvent event;
+		event.workerId = _workerId;
+		event.tileId = tileId;
+		event.step = _job.step;
+		event.start = duration_cast<microseconds>(start - sessionStart).count();
+		event.duration = duration;
+		stats.trace.push_back(event);
+	}
+	if (finished && --tileRemainingJobs[tileId] == 0)
+	{
+		tileStamp.store(getTileStamp(_job.epoch, _job.step), std::memory_order_release);
+		damageDisplay();
+	}
+	leaveTile(tileId);
+}
+
+/* Finds the logical processors of the machine with their cores, NUMA nodes and efficiency classes, in the order
+pinned workers are placed on them (see 'MclCpuTopology'). Without that information from Windows, every one of
+'thread::hardware_concurrency' processors is taken as a core of its own on one node */
+MclCpuTopology detectCpuTopology()
+{
+	MclCpuTopology topology;
+	DWORD length = 0;
+	GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+	vector<uint8_t> buffer(length);
+	vector<GROUP_AFFINITY> nodeMasks;
+	vector<int> nodeNumbers;
+	if (length > 0 && GetLogicalProcessorInformationEx(RelationAll, (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)buffer.data(), &length))
+	{
+		for (DWORD offset = 0; offset < length;)
+		{
+			const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX& info = *(const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)(buffer.data() + offset);
+			if (info.Relationship == RelationProcessorCore)
+			{
+				// a core is always within one processor group
+				const GROUP_AFFINITY& mask = info.Processor.GroupMask[0];
+				int sibling = 0;
+				for (int bit = 0; bit < (int)sizeof(KAFFINITY) * 8; bit++)
+				{
+					if ((mask.Mask & ((KAFFINITY)1 << bit)) == 0) continue;
+					MclLogicalCpu cpu;
+					cpu.group = mask.Group;
+					cpu.number = bit;
+					cpu.core = topology.coreCount;
+					cpu.sibling = sibling++;
+					cpu.efficiency = info.Processor.EfficiencyClass;
+					topology.cpus.push_back(cpu);
+				}
+				topology.coreCount++;
+			}
+			else if (info.Relationship == RelationNumaNode)
+			{
+				nodeMasks.push_back(info.NumaNode.GroupMask);
+				nodeNumbers.push_back((int)info.NumaNode.NodeNumber);
+			}
+			offset += info.Size;
+		}
+	}
+	if (topology.cpus.empty())
+	{
+		topology.coreCount = std::max(1, (int)thread::hardware_concurrency());
+		for (int i = 0; i < topology.coreCount; i++)
+		{
+			MclLogicalCpu cpu;
+			cpu.group = i / 64;
+			cpu.number = i % 64;
+			cpu.core = i;
+			topology.cpus.push_back(cpu);
+		}
+	}
+
+	// number the nodes which have processors from 0, in the order of Windows' node numbers
+	vector<int> numbers = nodeNumbers;
+	std::sort(numbers.begin(), numbers.end());
+	numbers.erase(std::unique(numbers.begin(), numbers.end()), numbers.end());
+	for (MclLogicalCpu& cpu : topology.cpus)
+	{
+		for (size_t i = 0; i < nodeMasks.size(); i++)
+		{
+			if (nodeMasks[i].Group != cpu.group || (nodeMasks[i].Mask & ((KAFFINITY)1 << cpu.number)) == 0) continue;
+			cpu.node = (int)(std::lower_bound(numbers.begin(), numbers.end(), nodeNumbers[i]) - numbers.begin());
+		}
+	}
+	vector<bool> hasCpus(std::max<size_t>(numbers.size(), 1), false);
+	for (const MclLogicalCpu& cpu : topology.cpus) hasCpus[cpu.node] = true;
+	vector<int> dense(hasCpus.size(), 0);
+	topology.nodeCount = 0;
+	for (size_t node = 0; node < hasCpus.size(); node++) if (hasCpus[node]) dense[node] = topology.nodeCount++;
+	for (MclLogicalCpu& cpu : topology.cpus) cpu.node = dense[cpu.node];
+
+	for (const MclLogicalCpu& cpu : topology.cpus) topology.fastestEfficiency = std::max(topology.fastestEfficiency, cpu.efficiency);
+	for (const MclLogicalCpu& cpu : topology.cpus) if (cpu.sibling == 0 && cpu.efficiency == topology.fastestEfficiency) topology.fastCoreCount++;
+
+	// hardware threads of the same tier (the same sibling number and efficiency class) are dealt out to the nodes in
+	// turn, by their rank among the processors of that tier on their node
+	auto isEarlierTier = [](const MclLogicalCpu& _a, const MclLogicalCpu& _b)
+	{
+		if (_a.sibling != _b.sibling) return _a.sibling < _b.sibling;
+		return _a.efficiency > _b.efficiency;
+	};
+	std::stable_sort(topology.cpus.begin(), topology.cpus.end(), [&isEarlierTier](const MclLogicalCpu& _a, const MclLogicalCpu& _b)
+	{
+		if (isEarlierTier(_a, _b) || isEarlierTier(_b, _a)) return isEarlierTier(_a, _b);
+		return _a.node < _b.node;
+	});
+	vector<int> rank(topology.cpus.size(), 0);
+	for (size_t i = 1; i < topology.cpus.size(); i++)
+	{
+		const MclLogicalCpu& cpu = topology.cpus[i], & previous = topology.cpus[i - 1];
+		if (!isEarlierTier(previous, cpu) && cpu.node == previous.node) rank[i] = rank[i - 1] + 1;
+	}
+	vector<size_t> order(topology.cpus.size());
+	for (size_t i = 0; i < order.size(); i++) order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&topology, &rank, &isEarlierTier](size_t _a, size_t _b)
+	{
+		const MclLogicalCpu& a = topology.cpus[_a], & b = topology.cpus[_b];
+		if (isEarlierTier(a, b) || isEarlierTier(b, a)) return isEarlierTier(a, b);
+		if (rank[_a] != rank[_b]) return rank[_a] < rank[_b];
+		return a.node < b.node;
+	});
+	vector<MclLogicalCpu> placed;
+	for (size_t i : order) placed.push_back(topology.cpus[i]);
+	topology.cpus = placed;
+	return topology;
+}
+
+/* Prints what 'detectCpuTopology' found */
+void printCpuTopology()
+{
+	cout << cpuTopology.cpus.size() << " logical processors on " << cpuTopology.coreCount << " cores";
+	if (cpuTopology.fastCoreCount < cpuTopology.coreCount) cout << " (" << cpuTopology.fastCoreCount << " performance and " << cpuTopology.coreCount - cpuTopology.fastCoreCount << " efficient ones)";
+	if (cpuTopology.nodeCount > 1) cout << " in " << cpuTopology.nodeCount << " NUMA nodes";
+	cout << "." << endl;
+}
+
+/* Gets the number of threads used when none is given: one per logical processor, as far as 'MAX_THREADS' allows */
+int getAutomaticThreadCount()
+{
+	return std::max(1, std::min((int)cpuTopology.cpus.size(), MAX_THREADS));
+}
+
+/* Gets the processor worker '_workerId' is pinned to. With more workers than processors, they share them in turn */
+const MclLogicalCpu& getWorkerCpu(int _workerId)
+{
+	return cpuTopology.cpus[_workerId % cpuTopology.cpus.size()];
+}
+
+/* Is '_cpu' on one of the fastest cores of the machine (any core, unless the CPU is hybrid)? */
+bool isFastCpu(const MclLogicalCpu& _cpu)
+{
+	return _cpu.efficiency == cpuTopology.fastestEfficiency;
+}
+
+/* Pins the calling thread to processor '_cpu'. Gets the processors it could run on before in '_previous' */
+bool pinThread(const MclLogicalCpu& _cpu, GROUP_AFFINITY& _previous)
+{
+	GROUP_AFFINITY affinity = {};
+	affinity.Group = (WORD)_cpu.group;
+	affinity.Mask = (KAFFINITY)1 << _cpu.number;
+	return SetThreadGroupAffinity(GetCurrentThread(), &affinity, &_previous) != 0;
+}
+
+/* Pins the calling worker '_workerId' to its processor with '_pin', or lets it run on the processors it could
+run on before, kept in '_unpinned'. Returns '_pin', a failed attempt is not repeated */
+bool setWorkerPinning(int _workerId, bool _pin, GROUP_AFFINITY& _unpinned)
+{
+	if (_pin) pinThread(getWorkerCpu(_workerId), _unpinned);
+	else SetThreadGroupAffinity(GetCurrentThread(), &_unpinned, nullptr);
+	return _pin;
+}
+
+/* Splits '_height' rows into a band of whole tile rows for each NUMA node, in proportion to how many of the first
+'_workerCount' workers are pinned to it. Gets the first row past each band */
+vector<int> getNodeBands(int _height, int _workerCount)
+{
+	vector<int> workers(cpuTopology.nodeCount, 0), ends(cpuTopology.nodeCount);
+	for (int i = 0; i < _workerCount; i++) workers[getWorkerCpu(i).node]++;
+	int tileRows = (_height + TILE_SIZE - 1) / TILE_SIZE, sum = 0;
+	for (int node = 0; node < cpuTopology.nodeCount; node++)
+	{
+		sum += workers[node];
+		ends[node] = std::min(_height, (int)((long long)tileRows * sum / _workerCount) * TILE_SIZE);
+	}
+	return ends;
+}
+
+/* Gets a dealer for the tiles of a pass of frame '_epoch' over '_workerCount' workers, see 'dealTile'.
+Unpinned workers are dealt the tiles in turn. Pinned workers on a machine with several NUMA nodes only get the
+tiles of their node's band of the frame, whose memory is on that node (see 'clearBackBuffer'). On a hybrid CPU,
+the tiles which took longer than average in the earlier passes of the frame go to the workers on the fast cores */
+MclTileDealer getTileDealer(const MclView& _view, uint32_t _epoch, int _workerCount)
+{
+	MclTileDealer dealer;
+	dealer.workerCount = _workerCount;
+	if (!threadPinning) return dealer;
+	dealer.workers.resize(cpuTopology.nodeCount);
+	dealer.fastWorkers.assign(cpuTopology.nodeCount, 0);
+	for (int i = 0; i < _workerCount; i++) if (isFastCpu(getWorkerCpu(i))) dealer.workers[getWorkerCpu(i).node].push_back(i);
+	for (int node = 0; node < cpuTopology.nodeCount; node++) dealer.fastWorkers[node] = (int)dealer.workers[node].size();
+	for (int i = 0; i < _workerCount; i++) if (!isFastCpu(getWorkerCpu(i))) dealer.workers[getWorkerCpu(i).node].push_back(i);
+	dealer.dealtTo.assign(cpuTopology.nodeCount * 3, 0);
+	dealer.bandEnds = getNodeBands(_view.height, _workerCount);
+	if (cpuTopology.fastCoreCount < cpuTopology.coreCount && _epoch == frameEpoch)
+	{
+		long long total = 0;
+		int costed = 0;
+		for (int tileId = 0; tileId < getTileCount(_view); tileId++)
+		{
+			int cost = tileCostArray[tileId].load(std::memory_order_relaxed);
+			if (cost <= 0) continue;
+			total += cost;
+			costed++;
+		}
+		if (costed > 0) dealer.meanCost = (double)total / costed;
+	}
+	return dealer;
+}
+
+/* Picks the worker to queue the tile with id '_tileId' and top row '_y' for, see 'getTileDealer' */
+int dealTile(MclTileDealer& _dealer, int _y, int _tileId)
+{
+	if (_dealer.workers.empty()) return _dealer.dealt++ % _dealer.workerCount;
+	int node = 0;
+	while (node + 1 < (int)_dealer.bandEnds.size() && _y >= _dealer.bandEnds[node]) node++;
+	const vector<int>& workers = _dealer.workers[node];
+	int fast = _dealer.fastWorkers[node];
+	if (workers.empty()) return _dealer.dealt++ % _dealer.workerCount;
+	_dealer.dealt++;
+
+	// tiles of unknown cost go to any worker of the node, costly ones to the fast cores and cheap ones to the others
+	int cost = _dealer.meanCost > 0.0 ? tileCostArray[_tileId].load(std::memory_order_relaxed) : 0;
+	if (cost > 0 && fast > 0 && fast < (int)workers.size())
+	{
+		if (cost > _dealer.meanCost) return workers[_dealer.dealtTo[node * 3 + 1]++ % fast];
+		return workers[fast + _dealer.dealtTo[node * 3 + 2]++ % ((int)workers.size() - fast)];
+	}
+	return workers[_dealer.dealtTo[node * 3]++ % workers.size()];
+}
+
+/* Takes the next job for a worker. Tries the front of the worker's own queue first,
+then steals from the back of the other queues. Returns false if every queue is empty */
+bool takeJob(int _workerId, MclJob& _job)
+{
+	{
+		MclWorkerQueue& own = workerQueueArray[_workerId];
+		unique_lock<mutex> lk(own.jobsMutex);
+		if (!own.jobs.empty())
+		{
+			_job = own.jobs.front();
+			own.jobs.pop_front();
+			--queuedJobCount;
+			return true;
+		}
+	}
+	// pinned workers steal from the workers on their own NUMA node first, whose tiles are in the node's memory as well
+	int workerCount = spawnedWorkerCount;
+	bool pinned = threadPinning && cpuTopology.nodeCount > 1;
+	for (int pass = pinned ? 0 : 1; pass < 2; pass++)
+	{
+		for (int i = 1; i < workerCount; i++)
+		{
+			int victimId = (_workerId + i) % workerCount;
+			if (pinned && (getWorkerCpu(victimId).node == getWorkerCpu(_workerId).node) != (pass == 0)) continue;
+			MclWorkerQueue& victim = workerQueueArray[victimId];
+			unique_lock<mutex> lk(victim.jobsMutex);
+			if (!victim.jobs.empty())
+			{
+				_job = victim.jobs.back();
+				victim.jobs.pop_back();
+				--queuedJobCount;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/* main function of each persistent worker thread. Takes jobs from the queues until the pool is shut down,
+pinned to its processor while 'threadPinning' is on */
+void workerLoop(int _workerId)
+{
+	try
+	{
+		bool pinned = false;
+		GROUP_AFFINITY unpinned = {};
+		while (true)
+		{
+			MclJob job;
+			{
+				unique_lock<mutex> lk(jobQueueMutex);
+				jobAvailable.wait(lk, [_workerId] { return workerPoolShutdown || (_workerId < activeWorkerCount && queuedJobCount > 0); });
+				if (workerPoolShutdown) return;
+			}
+			if (pinned != threadPinning) pinned = setWorkerPinning(_workerId, !pinned, unpinned);
+			if (!takeJob(_workerId, job)) continue;
+			computeTile(job, _workerId);
+
+			{
+				unique_lock<mutex> lk(jobQueueMutex);
+				if (--pendingJobCount == 0) jobsFinished.notify_all();
+			}
+		}
+	}
+	catch (const exception& e) { cout << "ERROR (workerLoop)\n" << e.what() << endl; }
+}
+
+/* Sets the number of active workers. New threads are only spawned when the pool grows
+past its largest size, extra workers are parked rather than destroyed */
+void resizeWorkerPool(int _workerCount)
+{
+	try
+	{
+		unique_lock<mutex> lk(jobQueueMutex);
+		while ((int)workerList.size() < _workerCount) workerList.push_back(thread(workerLoop, (int)workerList.size()));
+		spawnedWorkerCount = (int)workerList.size();
+		activeWorkerCount = _workerCount;
+		jobAvailable.notify_all();
+	}
+	catch (const exception& e) { cout << "ERROR (resizeWorkerPool)\n" << e.what() << endl; }
+}
+
+/* Adds a job to the queue of the given worker and wakes the workers to compute it.
+'_front' puts it where the owner takes its next job from, for work split off the owner's current job */
+void submitJob(int _workerId, const MclJob& _job, bool _front)
+{
+	unique_lock<mutex> lk(jobQueueMutex);
+	{
+		MclWorkerQueue& queue = workerQueueArray[_workerId];
+		unique_lock<mutex> qlk(queue.jobsMutex);
+		if (_front) queue.jobs.push_front(_job);
+		else queue.jobs.push_back(_job);
+	}
+	++queuedJobCount;
+	++pendingJobCount;
+	jobAvailable.notify_all();
+}
+
+/* Splits the window into tiles and deals the ones marked in '_needed' out to the active workers' queues,
+for one pass of a frame (see 'addSamples' for '_step' and '_refine'), subdivided with '_subdivide', or
+continuing the last frame from its limit '_resumeFrom' (see 'resumeMandelbrot') */
+void submitTiles(MclKernel _kernel, const MclView& _view, uint32_t _epoch, int _workerCount, const vector<bool>& _needed, int _step, bool _refine, bool _subdivide, int _resumeFrom)
+{
+	MclTileDealer dealer = getTileDealer(_view, _epoch, _workerCount);
+	for (int y = 0; y < _view.height; y += TILE_SIZE)
+	{
+		for (int x = 0; x < _view.width; x += TILE_SIZE)
+		{
+			if (!_needed[getTileId(_view, x, y)]) continue;
+			MclJob job(_kernel, _view, _epoch, x, std::min(x + TILE_SIZE, _view.width), y, std::min(y + TILE_SIZE, _view.height));
+			job.step = _step;
+			job.refine = _refine;
+			job.subdivide = _subdivide;
+			job.resumeFrom = _resumeFrom;
+			submitJob(dealTile(dealer, y, getTileId(_view, x, y)), job);
+		}
+	}
+}
+
+/* Queues the tiles of frame '_epoch' which are finished at full resolution to have their edges anti-aliased by kernel
+'_kernel', see 'antialiasTile'. Tiles which already are, like reused ones, are left alone */
+void submitAntialiasTiles(MclKernel _kernel, const MclView& _view, uint32_t _epoch, int _workerCount)
+{
+	MclTileDealer dealer = getTileDealer(_view, _epoch, _workerCount);
+	for (int y = 0; y < _view.height; y += TILE_SIZE)
+	{
+		for (int x = 0; x < _view.width; x += TILE_SIZE)
+		{
+			if (tileStampArray[getTileId(_view, x, y)].load(std::memory_order_acquire) != getTileStamp(_epoch, 1)) continue;
+			MclJob job(_kernel, _view, _epoch, x, std::min(x + TILE_SIZE, _view.width), y, std::min(y + TILE_SIZE, _view.height));
+			job.step = TILE_STEP_ANTIALIASED;
+			job.antialias = true;
+			submitJob(dealTile(dealer, y, getTileId(_view, x, y)), job);
+		}
+	}
+}
+
+/* Blocks until every submitted job has been computed or cancelled */
+void waitForJobs()
+{
+	unique_lock<mutex> lk(jobQueueMutex);
+	jobsFinished.wait(lk, [] { return pendingJobCount == 0; });
+}
+
+/* Blocks until every submitted job has been computed, or until the view of generation '_generation' went stale,
+which leaves the workers to drop the rest of its jobs on their own. Returns true if the workers are idle */
+bool waitForFrame(uint32_t _generation)
+{
+	unique_lock<mutex> lk(jobQueueMutex);
+	jobsFinished.wait(lk, [_generation] { return pendingJobCount == 0 || isStale(_generation); });
+	return pendingJobCount == 0;
+}
+
+/* Do the back buffers have to be allocated afresh to place their bands on the NUMA nodes of the pinned workers? */
+bool needsPlacing()
+{
+	return threadPinning && cpuTopology.nodeCount > 1 && !backBufferPlaced;
+}
+
+/* Clears the back buffers after they were resized for '_view'. With the workers pinned over several NUMA nodes,
+a thread on each node clears the node's band of rows (see 'getNodeBands'), so the pages of a freshly allocated band
+are touched first, and so placed, on the node whose workers compute its tiles */
+void clearBackBuffer(const MclView& _view)
+{
+	if (!threadPinning || cpuTopology.nodeCount == 1)
+	{
+		pixels.clear();
+		fractionPixels.clear();
+		orbitPixels.clear();
+		return;
+	}
+	backBufferPlaced = true;
+	vector<int> ends = getNodeBands(_view.height, threadCount);
+	vector<thread> clearers;
+	for (int node = 0; node < cpuTopology.nodeCount; node++)
+	{
+		int startY = node == 0 ? 0 : ends[node - 1], endY = ends[node];
+		if (startY == endY) continue;
+		clearers.push_back(thread([node, startY, endY]
+		{
+			GROUP_AFFINITY previous;
+			for (const MclLogicalCpu& cpu : cpuTopology.cpus)
+			{
+				if (cpu.node != node) continue;
+				pinThread(cpu, previous);
+				break;
+			}
+			pixels.clearRows(startY, endY);
+			fractionPixels.clearRows(startY, endY);
+			orbitPixels.clearRows(startY, endY);
+		}));
+	}
+	for (thread& clearer : clearers) clearer.join();
+}
+
+/* Sizes the back buffers and the tile arrays for a frame of '_view'. Their storage only grows, and a buffer keeps its
+contents if its size did not change. Must be called with 'frameViewMutex' held, and while the workers are idle if the size changes
+or the buffers are placed afresh (see 'needsPlacing') */
+void resizeBackBuffer(const MclView& _view)
+{
+	if (needsPlacing())
+	{
+		pixels.release();
+		fractionPixels.release();
+		orbitPixels.release();
+	}
+	bool reshaped = pixels.reshape(_view.width, _view.height);
+	fractionPixels.reshape(_view.width, _view.height);
+	orbitPixels.reshape(_view.width, _view.height);
+	if (reshaped) clearBackBuffer(_view);
+	int tileCount = getTileCount(_view);
+	if (tileCount <= tileCapacity) return;
+	tileStampArray.reset(new std::atomic<uint32_t>[tileCount]());
+	tileRemainingJobs.reset(new std::atomic<int>[tileCount]());
+	tileCostArray.reset(new std::atomic<int>[tileCount]());
+	tileSampleArray.reset(new MclAaSample[(size_t)tileCount * AA_TILE_SAMPLES]);
+	tileSampleCounts.reset(new int[tileCount]());
+	tileWriterArray.reset(new std::atomic<uint64_t>[tileCount]());
+	tileCapacity = tileCount;
+}
+
+/* Starts a new frame for '_view', so the rendering thread drops the old tiles, and clears the tile costs.
+Returns the epoch of the new frame. Must only be called by the main thread. Workers may still be finishing jobs of
+a stale frame, which is fine as long as the back buffer keeps its size; otherwise they are waited for first */
+uint32_t startFrame(const MclView& _view)
+{
+	if (_view.width != pixels.width || _view.height != pixels.height || needsPlacing()) waitForJobs();
+	unique_lock<mutex> lk(frameViewMutex);
+	resizeBackBuffer(_view);
+	for (int tileId = 0; tileId < getTileCount(_view); tileId++) tileCostArray[tileId].store(0, std::memory_order_relaxed);
+	frameView = _view;
+	uint32_t epoch = ++frameEpoch;
+	damageDisplay();
+	return epoch;
+}
+
+/* Checks if '_to' is '_from' moved by a whole number of pixels (less than a frame), and gets that number.
+The pixel sizes and the resolution must match exactly, as they do after 'panView' */
+bool getPanOffset(const MclView& _from, const MclView& _to, int& _dx, int& _dy)
+{
+	if (_from.pixelWidth != _to.pixelWidth || _from.pixelHeight != _to.pixelHeight || _from.width != _to.width || _from.height != _to.height) return false;
+	double dx = toDouble(_to.exactLeft - _from.exactLeft) / _from.pixelWidth, dy = toDouble(_to.exactTop - _from.exactTop) / _from.pixelHeight;
+	if (fabs(dx) >= _from.width || fabs(dy) >= _from.height) return false;
+	_dx = (int)lround(dx);
+	_dy = (int)lround(dy);
+	return fabs(dx - _dx) < 1e-6 && fabs(dy - _dy) < 1e-6;
+}
+
+/* Reuses the fully finished tiles of the previous frame which are still on screen after a pan by whole tiles.
+They are moved to their new place in the back buffer and published for '_epoch' right away, and cleared in '_needed'.
+Returns the number of tiles reused. Must only be called by the main thread before the tiles of '_epoch' are submitted */
+int reuseTiles(const MclView& _previousView, uint32_t _previousEpoch, const MclView& _view, uint32_t _epoch, vector<bool>& _needed)
+{
+	int dx = 0, dy = 0;
+	if (!getPanOffset(_previousView, _view, dx, dy) || (dx == 0 && dy == 0) || dx % TILE_SIZE != 0 || dy % TILE_SIZE != 0) return 0;
+
+	// find the tiles whose source tile was finished, is on screen, and is not cut short by the edge of the window.
+	// Anti-aliased ones take their samples along, which are copied out first as the tiles move over each other
+	vector<int> reused, reusedSteps;
+	vector<MclAaSample> reusedSamples;
+	vector<int> reusedSampleCounts;
+	for (int tileY = 0; tileY < getTileRows(_view); tileY++)
+	{
+		for (int tileX = 0; tileX < getTileColumns(_view); tileX++)
+		{
+			int sourceX = tileX * TILE_SIZE + dx, sourceY = tileY * TILE_SIZE + dy;
+			if (sourceX < 0 || sourceX >= _view.width || sourceY < 0 || sourceY >= _view.height) continue;
+			int sourceId = getTileId(_view, sourceX, sourceY);
+			uint32_t stamp = tileStampArray[sourceId].load(std::memory_order_relaxed);
+			if (!isTileFinished(stamp, _previousEpoch)) continue;
+			int width = std::min(TILE_SIZE, _view.width - tileX * TILE_SIZE), height = std::min(TILE_SIZE, _view.height - tileY * TILE_SIZE);
+			if (_view.width - sourceX < width || _view.height - sourceY < height) continue;
+			reused.push_back(tileY * getTileColumns(_view) + tileX);
+			reusedSteps.push_back(getStampStep(stamp));
+			int sampleCount = getStampStep(stamp) == TILE_STEP_ANTIALIASED ? tileSampleCounts[sourceId] : 0;
+			reusedSamples.insert(reusedSamples.end(), &tileSampleArray[(size_t)sourceId * AA_TILE_SAMPLES], &tileSampleArray[(size_t)sourceId * AA_TILE_SAMPLES] + sampleCount);
+			reusedSampleCounts.push_back(sampleCount);
+		}
+	}
+	if (reused.empty()) return 0;
+
+	// move them, marking each as being written in the meantime like a worker would
+	previousPixels.copyFrom(pixels);
+	previousFractions.copyFrom(fractionPixels);
+	size_t sampleOffset = 0;
+	for (size_t i = 0; i < reused.size(); i++)
+	{
+		int tileId = reused[i];
+		int startX, endX, startY, endY;
+		getTileBounds(_view, tileId, startX, endX, startY, endY);
+		enterTile(tileId, _epoch);
+		tileStampArray[tileId].store(TILE_WRITING, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		for (int y = startY; y < endY; y++)
+		{
+			memcpy(pixels.row(y) + startX, previousPixels.row(y + dy) + startX + dx, sizeof(uint32_t) * (endX - startX));
+			memcpy(fractionPixels.row(y) + startX, previousFractions.row(y + dy) + startX + dx, sizeof(float) * (endX - startX));
+		}
+		if (reusedSampleCounts[i] > 0) memcpy(&tileSampleArray[(size_t)tileId * AA_TILE_SAMPLES], &reusedSamples[sampleOffset], sizeof(MclAaSample) * reusedSampleCounts[i]);
+		tileSampleCounts[tileId] = reusedSampleCounts[i];
+		sampleOffset += reusedSampleCounts[i];
+		_needed[tileId] = false;
+	}
+	for (size_t i = 0; i < reused.size(); i++)
+	{
+		tileStampArray[reused[i]].store(getTileStamp(_epoch, reusedSteps[i]), std::memory_order_release);
+		leaveTile(reused[i]);
+	}
+	damageDisplay();
+	return (int)reused.size();
+}
+
+/* Checks if every tile of the back buffer was finished by the last pass of frame '_epoch', which has view '_view' */
+bool isFrameFinished(const MclView& _view, uint32_t _epoch)
+{
+	for (int i = 0; i < getTileCount(_view); i++) if (!isTileFinished(tileStampArray[i].load(std::memory_order_acquire), _epoch)) return false;
+	return true;
+}
+
+/* Drops the queued jobs of stale views, which have not been picked up by a worker yet. Jobs of a frame already
+submitted for the current view stay. Wakes the main thread as well, which waits for a frame until it is stale */
+void cancelQueuedJobs()
+{
+	unique_lock<mutex> lk(jobQueueMutex);
+	for (int i = 0; i < MAX_THREADS; i++)
+	{
+		MclWorkerQueue& queue = workerQueueArray[i];
+		unique_lock<mutex> qlk(queue.jobsMutex);
+		int queued = (int)queue.jobs.size();
+		queue.jobs.erase(std::remove_if(queue.jobs.begin(), queue.jobs.end(), [](const MclJob& _job) { return isStale(_job.view.generation); }), queue.jobs.end());
+		pendingJobCount -= queued - (int)queue.jobs.size();
+		queuedJobCount -= queued - (int)queue.jobs.size();
+	}
+	jobsFinished.notify_all();
+}
+
+/* Sums up the counters the workers kept for frame '_epoch', all but the trace.
+Must only be called by the main thread while the workers are idle */
+MclWorkerStats getFrameStats(uint32_t _epoch)
+{
+	MclWorkerStats total;
+	for (const MclWorkerStats& stats : workerStatsArray)
+	{
+		if (stats.epoch != _epoch) continue;
+		total.busyMicroseconds += stats.busyMicroseconds;
+		total.iterations += stats.iterations;
+		total.escapedPixels += stats.escapedPixels;
+		total.limitPixels += stats.limitPixels;
+		total.interiorPixels += stats.interiorPixels;
+		total.filledPixels += stats.filledPixels;
+		total.antialiasedPixels += stats.antialiasedPixels;
+		total.extraSamples += stats.extraSamples;
+	}
+	return total;
+}
+
+/* Prints the counters of frame '_epoch' just computed on one line: the iterations and their rate, what came of the pixels,
+the mean and slowest tile, and how far the busiest of the '_threadCount' workers was above their mean busy time */
+void printFrameStats(const MclView& _view, uint32_t _epoch, const MclWorkerStats& _stats, int _timeTaken, int _threadCount)
+{
+	long long tileTotal = 0;
+	int costedTiles = 0, slowestTile = 0, slowestCost = 0;
+	for (int tileId = 0; tileId < getTileCount(_view); tileId++)
+	{
+		int cost = tileCostArray[tileId].load(std::memory_order_relaxed);
+		if (cost == 0) continue; // reused or taken from the cache
+		tileTotal += cost;
+		costedTiles++;
+		if (cost > slowestCost)
+		{
+			slowestCost = cost;
+			slowestTile = tileId;
+		}
+	}
+	long long busiest = 0;
+	for (int i = 0; i < _threadCount; i++) if (workerStatsArray[i].epoch == _epoch) busiest = std::max(busiest, workerStatsArray[i].busyMicroseconds);
+	double meanBusy = (double)_stats.busyMicroseconds / _threadCount;
+
+	cout << "  " << _stats.iterations / 1e6 << "M iterations (" << _stats.iterations / 1e6 / std::max(_timeTaken, 1) << " Giterations/s), "
+		<< _stats.escapedPixels << " pixels escaped, " << _stats.limitPixels << " at the limit, " << _stats.interiorPixels << " interior, "
+		<< _stats.filledPixels << " filled by subdivision";
+	if (_stats.antialiasedPixels > 0) cout << ", " << _stats.antialiasedPixels << " edge pixels anti-aliased with " << _stats.extraSamples << " samples";
+	if (costedTiles > 0) cout << ", " << tileTotal / costedTiles << "us per tile, slowest " << slowestCost << "us (tile " << slowestTile << ")";
+	if (meanBusy > 0.0) cout << ", busiest worker " << (int)lround((busiest / meanBusy - 1.0) * 100.0) << "% above the mean";
+	cout << endl;
+}
+
+/* Writes trace events to '_path' in the Chrome trace event format, which chrome://tracing and Perfetto can show
+as a timeline with one track per worker and one for the frames of the main thread */
+bool writeChromeTrace(const std::string& _path, const vector<MclTraceEvent>& _events)
+{
+	try
+	{
+		std::ofstream file(_path, std::ios::trunc);
+		if (!file)
+		{
+			cout << "Cannot create '" << _path << "'." << endl;
+			return false;
+		}
+		file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+		file << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": {\"name\": \"frames\"}}";
+		for (size_t i = 0; i < workerList.size(); i++) file << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << i + 1 << ", \"args\": {\"name\": \"worker " << i << "\"}}";
+		for (const MclTraceEvent& event : _events)
+		{
+			file << ",\n{\"name\": \"";
+			if (event.workerId < 0) file << "frame\", \"cat\": \"frame\"";
+			else file << "tile " << event.tileId << "\", \"cat\": \"tile\"";
+			file << ", \"ph\": \"X\", \"ts\": " << event.start << ", \"dur\": " << event.duration << ", \"pid\": 1, \"tid\": " << event.workerId + 1;
+			if (event.workerId >= 0) file << ", \"args\": {\"tile\": " << event.tileId << ", \"step\": " << event.step << "}";
+			file << "}";
+		}
+		file << "\n]}\n";
+		return (bool)file;
+	}
+	catch (const exception& e) { cout << "ERROR (writeChromeTrace)\n" << e.what() << endl; }
+	return false;
+}
+
+/* Adds the frame from '_start' to '_end' to 'traceEvents', and writes all of them to TRACE_PATH. The jobs the workers
+recorded are only taken along if they are '_idle', else they stay with the workers until a later frame.
+Must only be called by the main thread */
+void collectTrace(timer::time_point _start, timer::time_point _end, bool _idle)
+{
+	MclTraceEvent frame;
+	frame.workerId = -1;
+	frame.start = duration_cast<microseconds>(_start - sessionStart).count();
+	frame.duration = duration_cast<microseconds>(_end - _start).count();
+	traceEvents.push_back(frame);
+	for (MclWorkerStats& stats : workerStatsArray)
+	{
+		if (!_idle) break;
+		traceEvents.insert(traceEvents.end(), stats.trace.begin(), stats.trace.end());
+		stats.trace.clear();
+	}
+	writeChromeTrace(TRACE_PATH, traceEvents);
+}
+
+/* Stops and joins all worker threads */
+void shutdownWorkerPool()
+{
+	{
+		unique_lock<mutex> lk(jobQueueMutex);
+		workerPoolShutdown = true;
+		jobAvailable.notify_all();
+	}
+	for (int i = 0; i < (int)workerList.size(); i++)
+	{
+		if (workerList[i].joinable()) workerList[i].join();
+	}
+	workerList.clear();
+	spawnedWorkerCount = 0;
+}
+
+/* Converts a position on the screen into a position on the complex number plane */
+MclPoint getValueOfPixel(int _x, int _y)
+{
+	return MclPoint(toBigFixed(view.exactLeft, _x, view.pixelWidth), toBigFixed(view.exactTop, _y, view.pixelHeight));
+}
+
+/* Clears all pixels in the window, and sizes 'displayPixels' for a frame of '_view' */
+void clearPixels(const MclView& _view)
+{
+	displayPixels.resize(_view.width, _view.height);
+	displayPixels.clear();
+	displayFractions.resize(_view.width, _view.height);
+	displayFractions.clear();
+}
+
+// every palette of the colour pass, cycled through with the G key. The first one is the original magenta ramp
+const MclPaletteInfo paletteArray[] =
+{
+	{ "Classic", false, 2, { { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 1.0f } }, { 1.0f, 1.0f, 1.0f } },
+	{ "Ocean", true, 5, { { 0.0f, 0.03f, 0.39f }, { 0.13f, 0.42f, 0.8f }, { 0.93f, 1.0f, 1.0f }, { 1.0f, 0.67f, 0.0f }, { 0.0f, 0.01f, 0.0f } }, { 0.0f, 0.0f, 0.0f } },
+	{ "Fire", true, 4, { { 0.0f, 0.0f, 0.0f }, { 0.7f, 0.05f, 0.0f }, { 1.0f, 0.6f, 0.0f }, { 1.0f, 1.0f, 0.75f } }, { 0.0f, 0.0f, 0.0f } },
+	{ "Grey", true, 2, { { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f } }, { 0.0f, 0.0f, 0.0f } }
+};
+const int PALETTE_COUNT = sizeof(paletteArray) / sizeof(paletteArray[0]);
+
+/* Gets the lookup table of every palette, PALETTE_SIZE colours blended from its stops followed by the interior colour.
+The tables are built on first use */
+const vector<vector<MclPixel>>& getPaletteTables()
+{
+	static const vector<vector<MclPixel>> tables = []
+	{
+		vector<vector<MclPixel>> built;
+		for (const MclPaletteInfo& info : paletteArray)
+		{
+			vector<MclPixel> table(PALETTE_SIZE + 1);
+			for (int i = 0; i < PALETTE_SIZE; i++)
+			{
+				// a cyclic palette blends its last stop back into the first
+				float position = info.cyclic ? (float)i * info.stopCount / PALETTE_SIZE : (float)i * (info.stopCount - 1) / (PALETTE_SIZE - 1);
+				int stop = std::min((int)position, info.cyclic ? info.stopCount - 1 : info.stopCount - 2);
+				int next = (stop + 1) % info.stopCount;
+				float t = position - stop;
+				const float* a = info.stops[stop];
+				const float* b = info.stops[next];
+				table[i] = MclPixel(a[0] + (b[0] - a[0]) * t, a[1] + (b[1] - a[1]) * t, a[2] + (b[2] - a[2]) * t);
+			}
+			table[PALETTE_SIZE] = MclPixel(info.interior[0], info.interior[1], info.interior[2]);
+			built.push_back(table);
+		}
+		return built;
+	}();
+	return tables;
+}
+
+/* Gets the colouring of a frame with iteration limit '_maxIterations' from the colour settings.
+'_equalisation' is the histogram to equalise with, or nullptr to colour without */
+MclColouring getColouring(int _maxIterations, const vector<float>* _equalisation)
+{
+	MclColouring colouring;
+	int palette = paletteIndex;
+	colouring.palette = getPaletteTables()[palette].data();
+	colouring.cyclic = paletteArray[palette].cyclic;
+	colouring.smooth = smoothColouring;
+	colouring.maxIterations = _maxIterations;
+	colouring.equalisation = _equalisation;
+	return colouring;
+}
+
+/* Gets the cumulative histogram of the pixels of a buffer which escaped, for histogram equalisation: entry 'b' is the share
+of them in the bins below 'b', out of min(HISTOGRAM_BINS, '_maxIterations') bins. Each of '_threadCount' threads counts a band
+of rows into its own histogram, and the histograms are summed after */
+vector<float> getEqualisation(const MclIterationBuffer& _buffer, int _maxIterations, int _threadCount)
+{
+	int bins = std::min(HISTOGRAM_BINS, _maxIterations);
+	vector<vector<uint32_t>> histograms(_threadCount, vector<uint32_t>(bins, 0));
+	vector<thread> counters;
+	for (int t = 0; t < _threadCount; t++)
+	{
+		counters.push_back(thread([&_buffer, &histograms, _maxIterations, bins, _threadCount, t]
+		{
+			vector<uint32_t>& histogram = histograms[t];
+			for (int y = _buffer.height * t / _threadCount; y < _buffer.height * (t + 1) / _threadCount; y++)
+			{
+				const uint32_t* row = _buffer.row(y);
+				for (int x = 0; x < _buffer.width; x++) if (row[x] < (uint32_t)_maxIterations) histogram[(uint64_t)row[x] * bins / _maxIterations]++;
+			}
+		}));
+	}
+	for (thread& counter : counters) counter.join();
+
+	vector<float> cumulative(bins + 1, 0.0f);
+	uint64_t total = 0;
+	for (int b = 0; b < bins; b++)
+	{
+		for (const vector<uint32_t>& histogram : histograms) total += histogram[b];
+		cumulative[b + 1] = (float)total;
+	}
+	for (float& share : cumulative) share = total > 0 ? (float)(share / total) : 0.0f;
+	return cumulative;
+}
+
+/* Gets the palette entry of a pixel, PALETTE_SIZE for points inside the set. Cyclic palettes repeat every
+PALETTE_CYCLE_ITERATIONS, the others are stretched from 0 to the iteration limit, or over the equalisation histogram */
+inline int getPaletteIndex(uint32_t _iterations, float _fraction, const MclColouring& _colouring)
+{
+	if (_iterations >= (uint32_t)_colouring.maxIterations) return PALETTE_SIZE;
+	float smooth = std::max((float)_iterations + (_colouring.smooth ? _fraction : 0.0f), 0.0f);
+	if (_colouring.equalisation)
+	{
+		const vector<float>& cumulative = *_colouring.equalisation;
+		int bins = (int)cumulative.size() - 1;
+		float position = std::min(smooth * bins / _colouring.maxIterations, (float)bins);
+		int bin = std::min((int)position, bins - 1);
+		float share = cumulative[bin] + (position - bin) * (cumulative[bin + 1] - cumulative[bin]);
+		return std::min((int)(share * (PALETTE_SIZE - 1)), PALETTE_SIZE - 1);
+	}
+	if (_colouring.cyclic) return (int)(smooth * (float)(PALETTE_SIZE / PALETTE_CYCLE_ITERATIONS)) & (PALETTE_SIZE - 1);
+	return std::min((int)(smooth * ((float)(PALETTE_SIZE - 1) / _colouring.maxIterations)), PALETTE_SIZE - 1);
+}
+
+/* AVX2 colour pass over one row, 8 pixels at a time with the palette looked up by a gather.
+Same as 'getPaletteIndex' without equalisation, which the remaining pixels use */
+MCL_TARGET_AVX2 void colourRowAvx2(const uint32_t* _iterations, const float* _fractions, int _count, const MclColouring& _colouring, MclPixel* _colours)
+{
+	const __m256i lastInside = _mm256_set1_epi32(_colouring.maxIterations - 1), interiorIndex = _mm256_set1_epi32(PALETTE_SIZE);
+	const __m256i lastIndex = _mm256_set1_epi32(PALETTE_SIZE - 1);
+	const __m256 scale = _mm256_set1_ps(_colouring.cyclic ? (float)(PALETTE_SIZE / PALETTE_CYCLE_ITERATIONS) : (float)(PALETTE_SIZE - 1) / _colouring.maxIterations);
+	const __m256 fractionWeight = _mm256_set1_ps(_colouring.smooth ? 1.0f : 0.0f);
+	int i = 0;
+	for (; i + 8 <= _count; i += 8)
+	{
+		__m256i iterations = _mm256_loadu_si256((const __m256i*)(_iterations + i));
+		__m256i inside = _mm256_cmpeq_epi32(_mm256_min_epu32(iterations, lastInside), iterations); // unsigned iterations < limit
+		__m256 smooth = _mm256_fmadd_ps(_mm256_loadu_ps(_fractions + i), fractionWeight, _mm256_cvtepi32_ps(iterations));
+		__m256i index = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_max_ps(smooth, _mm256_setzero_ps()), scale));
+		index = _colouring.cyclic ? _mm256_and_si256(index, lastIndex) : _mm256_min_epi32(index, lastIndex);
+		index = _mm256_blendv_epi8(interiorIndex, index, inside);
+		_mm256_storeu_si256((__m256i*)(_colours + i), _mm256_i32gather_epi32((const int*)_colouring.palette, index, 4));
+	}
+	for (; i < _count; i++) _colours[i] = _colouring.palette[getPaletteIndex(_iterations[i], _fractions[i], _colouring)];
+}
+
+/* Colour pass, turns the iteration counts and escape fractions of a rectangle of a buffer into tightly packed rows
+of colours in '_colours'. Vectorised with AVX2 where the CPU has it, except for histogram equalisation */
+void colourPixels(const MclIterationBuffer& _buffer, const MclBuffer<float>& _fractions, int _startX, int _endX, int _startY, int _endY, const MclColouring& _colouring, MclPixel* _colours)
+{
+	bool vectorised = cpuFeature >= CPU_AVX2 && !_colouring.equalisation;
+	for (int y = _startY; y < _endY; y++)
+	{
+		const uint32_t* row = _buffer.row(y) + _startX;
+		const float* fractionRow = _fractions.row(y) + _startX;
+		if (vectorised) colourRowAvx2(row, fractionRow, _endX - _startX, _colouring, _colours);
+		else for (int x = 0; x < _endX - _startX; x++) _colours[x] = _colouring.palette[getPaletteIndex(row[x], fractionRow[x], _colouring)];
+		_colours += _endX - _startX;
+	}
+}
+
+/* Blends the extra samples of the anti-aliased pixels of a tile into its colours in '_colours', which were coloured by
+'colourPixels'. Each of those pixels becomes the average colour of its base sample and its extra samples */
+void blendSamples(const MclAaSample* _samples, int _count, const MclColouring& _colouring, MclPixel* _colours)
+{
+	for (int i = 0; i < _count;)
+	{
+		MclPixel& pixel = _colours[_samples[i].pixel];
+		int sum[3] = { pixel.colour[0], pixel.colour[1], pixel.colour[2] }, samples = 1;
+		for (uint16_t target = _samples[i].pixel; i < _count && _samples[i].pixel == target; i++, samples++)
+		{
+			const MclPixel& colour = _colouring.palette[getPaletteIndex(_samples[i].iterations, _samples[i].fraction, _colouring)];
+			for (int c = 0; c < 3; c++) sum[c] += colour.colour[c];
+		}
+		for (int c = 0; c < 3; c++) pixel.colour[c] = (uint8_t)((sum[c] + samples / 2) / samples);
+	}
+}
+
+/* Resamples 'displayPixels' from view '_from' into view '_to', nearest neighbour, resizing it if the resolution changed.
+Parts of the new view which were not on screen are cleared. Used as a placeholder while a new frame is computed.
+Only called from the rendering thread */
+void resamplePixels(const MclView& _from, const MclView& _to)
+{
+	resampledPixels.copyFrom(displayPixels);
+	resampledFractions.copyFrom(displayFractions);
+	displayPixels.resize(_to.width, _to.height);
+	displayFractions.resize(_to.width, _to.height);
+	double offsetX = toDouble(_to.exactLeft - _from.exactLeft) / _from.pixelWidth, scaleX = _to.pixelWidth / _from.pixelWidth;
+	double offsetY = toDouble(_to.exactTop - _from.exactTop) / _from.pixelHeight, scaleY = _to.pixelHeight / _from.pixelHeight;
+
+	vector<int> sourceX(_to.width);
+	for (int x = 0; x < _to.width; x++)
+	{
+		double position = floor(offsetX + (x + 0.5) * scaleX);
+		sourceX[x] = position >= 0 && position < _from.width ? (int)position : -1;
+	}
+	for (int y = 0; y < _to.height; y++)
+	{
+		uint32_t* row = displayPixels.row(y);
+		float* fractionRow = displayFractions.row(y);
+		double sourceY = floor(offsetY + (y + 0.5) * scaleY);
+		if (sourceY < 0 || sourceY >= _from.height)
+		{
+			memset(row, 0, sizeof(uint32_t) * _to.width);
+			memset(fractionRow, 0, sizeof(float) * _to.width);
+			continue;
+		}
+
+		const uint32_t* sourceRow = resampledPixels.row((int)sourceY);
+		const float* sourceFractionRow = resampledFractions.row((int)sourceY);
+		for (int x = 0; x < _to.width; x++)
+		{
+			row[x] = sourceX[x] >= 0 ? sourceRow[sourceX[x]] : 0;
+			fractionRow[x] = sourceX[x] >= 0 ? sourceFractionRow[sourceX[x]] : 0.0f;
+		}
+	}
+}
+
+/* Checks if every tile of 'displayPixels' was copied over from the last pass of frame '_displayedEpoch' */
+bool isDisplayFinished(uint32_t _displayedEpoch, const vector<uint32_t>& _displayedTileStamps)
+{
+	for (uint32_t stamp : _displayedTileStamps) if (!isTileFinished(stamp, _displayedEpoch)) return false;
+	return _displayedEpoch != 0;
+}
+
+/* Copies the tiles finished since the last call from the back buffer into 'displayPixels', and adds the ids of the
+tiles which changed to '_dirtyTiles'. Tiles of a coarse pass are shown with each computed pixel filling a block of
+step by step pixels. A tile is only kept if its stamp did not change during the copy (a seqlock), otherwise it is
+copied again later. When a new frame has started the old one is resampled into its view first, as a placeholder
+until the new tiles arrive, and true is returned. 'frameViewMutex' is held throughout, so the main thread cannot resize
+the back buffer during the copy. Only called from the rendering thread */
+bool copyFinishedTiles(uint32_t& _displayedEpoch, MclView& _displayedView, vector<uint32_t>& _displayedTileStamps, vector<int>& _dirtyTiles)
+{
+	unique_lock<mutex> lk(frameViewMutex);
+	uint32_t epoch = frameEpoch;
+	if (epoch == 0) return false; // no frame started yet
+	bool newFrame = epoch != _displayedEpoch;
+	if (newFrame)
+	{
+		if (_displayedEpoch == 0) clearPixels(frameView);
+		else resamplePixels(_displayedView, frameView);
+		_displayedEpoch = epoch;
+		_displayedView = frameView;
+		_displayedTileStamps.assign(getTileCount(frameView), TILE_WRITING);
+		displaySampleCounts.assign(getTileCount(frameView), 0);
+		displaySamples.resize((size_t)getTileCount(frameView) * AA_TILE_SAMPLES);
+		for (int tileId = 0; tileId < getTileCount(frameView); tileId++) _dirtyTiles.push_back(tileId);
+	}
+
+	for (int tileId = 0; tileId < getTileCount(_displayedView); tileId++)
+	{
+		uint32_t before = tileStampArray[tileId].load(std::memory_order_acquire);
+		if (getStampEpoch(before) != epoch || _displayedTileStamps[tileId] == before) continue;
+
+		int step = getStampStep(before);
+		int startX, endX, startY, endY;
+		getTileBounds(_displayedView, tileId, startX, endX, startY, endY);
+		for (int y = startY; y < endY; y++)
+		{
+			if (step <= 1) // full resolution, anti-aliased or not
+			{
+				memcpy(displayPixels.row(y) + startX, pixels.row(y) + startX, sizeof(uint32_t) * (endX - startX));
+				memcpy(displayFractions.row(y) + startX, fractionPixels.row(y) + startX, sizeof(float) * (endX - startX));
+				continue;
+			}
+			uint32_t* row = displayPixels.row(y);
+			float* fractionRow = displayFractions.row(y);
+			const uint32_t* sourceRow = pixels.row(y - y % step);
+			const float* sourceFractionRow = fractionPixels.row(y - y % step);
+			for (int x = startX; x < endX; x++)
+			{
+				row[x] = sourceRow[x - x % step];
+				fractionRow[x] = sourceFractionRow[x - x % step];
+			}
+		}
+		displaySampleCounts[tileId] = step == TILE_STEP_ANTIALIASED ? tileSampleCounts[tileId] : 0;
+		memcpy(&displaySamples[(size_t)tileId * AA_TILE_SAMPLES], &tileSampleArray[(size_t)tileId * AA_TILE_SAMPLES], sizeof(MclAaSample) * displaySampleCounts[tileId]);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (tileStampArray[tileId].load(std::memory_order_relaxed) != before) continue;
+		_displayedTileStamps[tileId] = before;
+		if (!newFrame) _dirtyTiles.push_back(tileId); // a new frame has all tiles in the list already
+	}
+	return newFrame;
+}
+
+/* Sizes the display texture for a frame of '_view', which clears it if the resolution changed. The texture is stretched
+over the window, smoothly when its resolution is not the window's. Only called from the rendering thread */
+void fitDisplayTexture(MclDisplayTexture& _texture, const MclView& _view)
+{
+	glBindTexture(GL_TEXTURE_2D, _texture.id);
+	if (_view.width != _texture.width || _view.height != _texture.height)
+	{
+		_texture.width = _view.width;
+		_texture.height = _view.height;
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, _texture.width, _texture.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	}
+	_texture.scale = _view.scale;
+	GLint filter = _view.scale == 1.0 ? GL_NEAREST : GL_LINEAR;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+}
+
+/* Shades every tile of the window by how long it took to compute, from clear for the cheapest to opaque red for the
+slowest tile of the frame. Only drawn while '_displayedEpoch' is still the frame being computed, as the costs are of that frame */
+void drawTileHeatmap(uint32_t _displayedEpoch, const MclView& _displayedView, double _scale)
+{
+	vector<int> costs(getTileCount(_displayedView));
+	{
+		unique_lock<mutex> lk(frameViewMutex);
+		if (frameEpoch != _displayedEpoch) return;
+		for (size_t tileId = 0; tileId < costs.size(); tileId++) costs[tileId] = tileCostArray[tileId].load(std::memory_order_relaxed);
+	}
+	if (costs.empty()) return;
+	int slowest = std::max(1, *std::max_element(costs.begin(), costs.end()));
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glBegin(GL_QUADS);
+	for (int tileId = 0; tileId < (int)costs.size(); tileId++)
+	{
+		float cost = (float)costs[tileId] / slowest;
+		int startX, endX, startY, endY;
+		getTileBounds(_displayedView, tileId, startX, endX, startY, endY);
+		glColor4f(1.0f, 1.0f - cost, 0.0f, 0.7f * cost);
+		glVertex2d(startX / _scale, startY / _scale);
+		glVertex2d(endX / _scale, startY / _scale);
+		glVertex2d(endX / _scale, endY / _scale);
+		glVertex2d(startX / _scale, endY / _scale);
+	}
+	glEnd();
+	glDisable(GL_BLEND);
+	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+/* signal main thread loop to recalculate mandelbrot, by requesting a frame of the window's current view */
+void signalRecalculation()
+{
+	try
+	{
+		{
+			unique_lock<mutex> lk(renderRequestMutex);
+			requestedView = view;
+			++viewGeneration;
+		}
+		cancelQueuedJobs();
+		renderRequested.notify_all();
+	}
+	catch (const exception& e) { cout << "ERROR (signalRecalculation)\n" << e.what() << endl; }
+}
+
+/* Takes the latest render request for the main loop: gets its view, and returns its generation */
+uint32_t takeRenderRequest(MclView& _view)
+{
+	unique_lock<mutex> lk(renderRequestMutex);
+	_view = requestedView;
+	return viewGeneration;
+}
+
+/* Blocks the main loop until a frame newer than generation '_generation' is requested, or the window is closed */
+void waitForRenderRequest(uint32_t _generation)
+{
+	unique_lock<mutex> lk(renderRequestMutex);
+	renderRequested.wait(lk, [_generation] { return isStale(_generation) || windowClosed; });
+}
+
+/* sets the number of threads to compute mandelbrot */
+bool setThreadCount(int _newThreadCount)
+{
+	bool valid = false;
+	try
+	{
+
+		if (_newThreadCount < 1)
+		{
+			cout << "Cannot have less than 1 thread." << endl;
+		}
+		else if (_newThreadCount > MAX_THREADS)
+		{
+			cout << "Cannot have more than than " << MAX_THREADS << " threads." << endl;
+		}
+		else
+		{
+			threadCountMutex.lock();
+			threadCount.store(_newThreadCount);
+			threadCountMutex.unlock();
+			resizeWorkerPool(_newThreadCount);
+			signalRecalculation();
+			cout << "Using " << _newThreadCount << " threads." << endl;
+			valid = true;
+		}
+	}
+	catch (const exception& e) { cout << "ERROR (setThreadCount)\n" << e.what() << endl; }
+	return valid;
+}
+
+/* gets the number of threads to compute mandelbrot */
+int getThreadCount()
+{
+	int $return;
+	threadCountMutex.lock();
+	$return = threadCount.load();
+	threadCountMutex.unlock();
+	return $return;
+}
+
+/* Gets '_view' changed to show the rectangle from '_left', '_top' to '_right', '_bottom' in the window,
+as 'setZoom' does. Returns false if its pixels would be too small */
+bool getZoomedView(const MclView& _view, MclBigFixed _left, MclBigFixed _right, MclBigFixed _top, MclBigFixed _bottom, MclView& _zoomed)
+{
+	int width = windowWidth, height = windowHeight;
+	double pixelWidth = toDouble(_right - _left) / width, pixelHeight = toDouble(_bottom - _top) / height;
+	if (fabs(pixelWidth) < MIN_PIXEL_SIZE * MAX_RENDER_SCALE || fabs(pixelHeight) < MIN_PIXEL_SIZE * MAX_RENDER_SCALE) return false;
+	_zoomed = _view;
+	_zoomed.exactLeft = _left;
+	_zoomed.exactTop = _top;
+	_zoomed.left = toDoubleDouble(_left);
+	_zoomed.top = toDoubleDouble(_top);
+	_zoomed.pixelWidth = pixelWidth;
+	_zoomed.pixelHeight = pixelHeight;
+	_zoomed.width = width;
+	_zoomed.height = height;
+	return true;
+}
+
+/* Sets global zoom values and signals main thread to re-compute mandelbrot */
+void setZoom(MclBigFixed _left, MclBigFixed _right, MclBigFixed _top, MclBigFixed _bottom)
+{
+	if (!getZoomedView(view, _left, _right, _top, _bottom, view))
+	{
+		cout << "Cannot zoom any further." << endl;
+		return;
+	}
+	signalRecalculation();
+}
+
+/* Gets the view a left click would zoom into, the one inside the cursor box. Returns false if it cannot zoom any further */
+bool getCursorZoomView(MclView& _zoomed)
+{
+	MclPoint topLeft = getValueOfPixel(cursorBox[0], cursorBox[1]);
+	MclPoint bottomRight = getValueOfPixel(cursorBox[4], cursorBox[5]);
+	return getZoomedView(view, topLeft.x, bottomRight.x, topLeft.y, bottomRight.y, _zoomed);
+}
+
+/* Changes the view to fit a window of '_width' by '_height' pixels. The centre of the view and the size of a pixel stay
+the same, so a bigger window shows more of the plane */
+void resizeView(int _width, int _height)
+{
+	MclBigFixed left = toBigFixed(view.exactLeft, (view.width - _width) / 2.0, view.pixelWidth), top = toBigFixed(view.exactTop, (view.height - _height) / 2.0, view.pixelHeight);
+	view.exactLeft = left;
+	view.exactTop = top;
+	view.left = toDoubleDouble(left);
+	view.top = toDoubleDouble(top);
+	view.width = _width;
+	view.height = _height;
+	signalRecalculation();
+}
+
+/* Gets the view of a frame showing the window's view '_view' at 'renderScale' times the resolution of the window.
+The pixels of the frame are exactly 1 / renderScale times the size of the window's, so a pan still moves the frame by
+whole pixels. The frame is rounded up to whole pixels, and may reach a little past the window */
+MclView getRenderView(const MclView& _view)
+{
+	MclView frame = _view;
+	frame.scale = renderScale;
+	frame.width = std::max(1, (int)ceil(_view.width * frame.scale));
+	frame.height = std::max(1, (int)ceil(_view.height * frame.scale));
+	frame.pixelWidth = _view.pixelWidth / frame.scale;
+	frame.pixelHeight = _view.pixelHeight / frame.scale;
+	return frame;
+}
+
+/* Gets the view of the frame the main loop computes for the window's view '_view' with the current settings,
+taken at generation '_generation' */
+MclView getFrameView(const MclView& _view, uint32_t _generation)
+{
+	MclView frame = getRenderView(_view);
+	frame.generation = _generation;
+	frame.interiorChecks = interiorChecks;
+	frame.maxIterations = getMaxIterations(frame);
+	return frame;
+}
+
+/* Moves the view by whole tiles, '_tilesX' to the right and '_tilesY' down. The pixel size stays exactly the same,
+so the main loop can reuse the tiles which are still on screen */
+void panView(int _tilesX, int _tilesY)
+{
+	MclBigFixed left = toBigFixed(view.exactLeft, _tilesX * TILE_SIZE, view.pixelWidth), top = toBigFixed(view.exactTop, _tilesY * TILE_SIZE, view.pixelHeight);
+	view.exactLeft = left;
+	view.exactTop = top;
+	view.left = toDoubleDouble(left);
+	view.top = toDoubleDouble(top);
+	signalRecalculation();
+}
+
+/* Shows the middle of the iteration map at its own fractal, pixel size, iteration limit and interior checks, at a whole
+number of pixels from its top left, so frames are filled from the map until the view zooms */
+void showIterationMap()
+{
+	if (!iterationMap.data)
+	{
+		cout << "No iteration map is open, start with --open <file.mcm>." << endl;
+		return;
+	}
+	const MclView& map = iterationMap.view;
+	int width = windowWidth, height = windowHeight;
+	view.exactLeft = toBigFixed(map.exactLeft, std::max(0, (map.width - width) / 2), map.pixelWidth);
+	view.exactTop = toBigFixed(map.exactTop, std::max(0, (map.height - height) / 2), map.pixelHeight);
+	view.left = toDoubleDouble(view.exactLeft);
+	view.top = toDoubleDouble(view.exactTop);
+	view.pixelWidth = map.pixelWidth;
+	view.pixelHeight = map.pixelHeight;
+	view.width = width;
+	view.height = height;
+	view.fractal = map.fractal;
+	maxIterations = map.maxIterations;
+	adaptiveIterations = false;
+	interiorChecks = map.interiorChecks;
+	signalRecalculation();
+}
+
+/* Sets the zoom values to display the whole fractal of 'view' */
+void resetZoom()
+{
+	if (view.fractal.formula == FORMULA_JULIA) setZoom(-1.8, 1.8, 1.35, -1.35);
+	else if (view.fractal.formula == FORMULA_BURNING_SHIP) setZoom(-2.5, 1.5, 1.0, -2.0);
+	else if (view.fractal.power > 2) setZoom(-1.6, 1.6, 1.2, -1.2);
+	else setZoom(-2.0, 1.0, 1.125, -1.125);
+}
+
+/* Name of '_fractal', for the console */
+std::string getFractalName(const MclFractal& _fractal)
+{
+	std::string name = "Mandelbrot set";
+	if (_fractal.formula == FORMULA_JULIA) name = "Julia set of c = " + std::to_string(_fractal.juliaR) + (_fractal.juliaI < 0.0 ? " - " : " + ") + std::to_string(abs(_fractal.juliaI)) + "i";
+	else if (_fractal.formula == FORMULA_BURNING_SHIP) name = "Burning Ship";
+	if (_fractal.power > 2) name += " of power " + std::to_string(_fractal.power);
+	return name;
+}
+
+/* Shows '_fractal' from its whole view */
+void setFractal(const MclFractal& _fractal)
+{
+	view.fractal = _fractal;
+	cout << "Fractal: " << getFractalName(_fractal) << "." << endl;
+	resetZoom();
+}
+
+/* Switches to the next formula, see 'MclFormula'. The Julia set is the one of the point in the middle of the cursor box */
+void cycleFormula()
+{
+	MclFractal fractal = view.fractal;
+	fractal.formula = (fractal.formula + 1) % FORMULA_COUNT;
+	fractal.juliaR = fractal.juliaI = 0.0;
+	if (fractal.formula == FORMULA_JULIA)
+	{
+		MclPoint centre = getValueOfPixel(int((cursorBox[0] + cursorBox[4]) / 2.0), int((cursorBox[1] + cursorBox[5]) / 2.0));
+		fractal.juliaR = toDouble(centre.x);
+		fractal.juliaI = toDouble(centre.y);
+	}
+	setFractal(fractal);
+}
+
+/* Switches to the next power of z, from 2 up to MAX_POWER and back */
+void cyclePower()
+{
+	MclFractal fractal = view.fractal;
+	fractal.power = fractal.power == MAX_POWER ? 2 : fractal.power + 1;
+	setFractal(fractal);
+}
+
+/* Switches to the next kernel supported by this CPU, or back to automatic selection after the last one, and recalculates */
+void cycleKernel()
+{
+	int next = kernelIndex;
+	do next++; while (next < KERNEL_COUNT && !isKernelSupported(next));
+	if (next == KERNEL_COUNT) next = -1;
+	kernelIndex = next;
+	if (next == -1) cout << "Choosing the kernel from the zoom depth." << endl;
+	else cout << "Using " << kernelArray[next].name << " kernel." << endl;
+	signalRecalculation();
+}
+
+/* Turns the perturbation kernel for deep zooms on or off, and recalculates */
+void togglePerturbation()
+{
+	preferPerturbation = !preferPerturbation;
+	cout << (preferPerturbation ? "Using perturbation for deep zooms." : "Using long double and double-double for deep zooms.") << endl;
+	signalRecalculation();
+}
+
+/* Turns the cardioid / bulb test and periodicity checking on or off, and recalculates */
+void toggleInteriorChecks()
+{
+	interiorChecks = !interiorChecks;
+	cout << (interiorChecks ? "Interior checks on." : "Interior checks off.") << endl;
+	signalRecalculation();
+}
+
+/* Turns progressive (coarse to fine) rendering on or off, and recalculates */
+void toggleProgressiveRendering()
+{
+	progressiveRendering = !progressiveRendering;
+	cout << (progressiveRendering ? "Progressive rendering on." : "Progressive rendering off.") << endl;
+	signalRecalculation();
+}
+
+/* Turns Mariani-Silver subdivision on or off, and recalculates */
+void toggleSubdivision()
+{
+	subdivision = !subdivision;
+	cout << (subdivision ? "Subdivision on." : "Subdivision off.") << endl;
+	signalRecalculation();
+}
+
+/* Toggles anti-aliasing the edges of finished frames, see 'antialiasTile' */
+void toggleAntialiasing()
+{
+	antialiasing = !antialiasing;
+	cout << (antialiasing ? "Anti-aliasing on." : "Anti-aliasing off.") << endl;
+	signalRecalculation();
+}
+
+/* Toggles pinning each worker to a processor of its own, see 'threadPinning'. The workers move on their next job */
+void toggleThreadPinning()
+{
+	threadPinning = !threadPinning;
+	cout << (threadPinning ? "Pinning threads to processors on." : "Pinning threads to processors off.") << endl;
+	signalRecalculation();
+}
+
+/* Switches to the next palette, and colours the frame again without recomputing it */
+void cyclePalette()
+{
+	paletteIndex = (paletteIndex + 1) % PALETTE_COUNT;
+	cout << "Palette: " << paletteArray[paletteIndex].name << "." << endl;
+	recolourPixels = true;
+	damageDisplay();
+}
+
+/* Turns smooth colouring by escape fractions on or off, and colours the frame again without recomputing it */
+void toggleSmoothColouring()
+{
+	smoothColouring = !smoothColouring;
+	cout << (smoothColouring ? "Smooth colouring on." : "Smooth colouring off.") << endl;
+	recolourPixels = true;
+	damageDisplay();
+}
+
+/* Turns histogram equalisation on or off, and colours the frame again without recomputing it */
+void toggleHistogramEqualisation()
+{
+	histogramEqualisation = !histogramEqualisation;
+	cout << (histogramEqualisation ? "Histogram equalisation on." : "Histogram equalisation off.") << endl;
+	recolourPixels = true;
+	damageDisplay();
+}
+
+/* Turns filling frames from the tile cache on or off, and recalculates. Tiles are still cached while it is off */
+void toggleTileCache()
+{
+	tileCaching = !tileCaching;
+	cout << (tileCaching ? "Tile cache on." : "Tile cache off.") << endl;
+	signalRecalculation();
+}
+
+/* Turns computing the view under the cursor into the tile cache while idle on or off */
+void toggleSpeculativePrefetch()
+{
+	speculativePrefetch = !speculativePrefetch;
+	cout << (speculativePrefetch ? "Prefetching the zoom under the cursor." : "Not prefetching the zoom under the cursor.") << endl;
+}
+
+/* Turns waiting for the vertical blank before showing a frame on or off */
+void toggleVsync()
+{
+	vsync = !vsync;
+	cout << (vsync ? "Vsync on." : "Vsync off.") << endl;
+	damageDisplay();
+}
+
+/* Doubles the most frames per second the window is drawn at with '_raise', halves it otherwise */
+void scaleFrameRateCap(bool _raise)
+{
+	frameRateCap = std::max(MIN_FRAME_RATE_CAP, std::min(MAX_FRAME_RATE_CAP, _raise ? frameRateCap * 2 : frameRateCap / 2));
+	cout << "Drawing at most " << frameRateCap << " frames per second." << endl;
+}
+
+/* turn the per-tile cost overlay on/off */
+void toggleTileHeatmap()
+{
+	tileHeatmap = !tileHeatmap;
+	cout << (tileHeatmap ? "Tile cost overlay on." : "Tile cost overlay off.") << endl;
+	redrawWindow = true;
+}
+
+/* start/stop recording the jobs of the frames computed from now on to TRACE_PATH */
+void toggleTraceRecording()
+{
+	traceRecording = !traceRecording;
+	if (traceRecording) cout << "Recording a trace of the worker pool to " << TRACE_PATH << "." << endl;
+	else cout << "Trace recording off." << endl;
+}
+
+/* Doubles the iteration limit with '_raise', halves it otherwise, and recalculates. When nothing else changed,
+raising it only continues the pixels which reached the old limit */
+void scaleMaxIterations(bool _raise)
+{
+	maxIterations = std::clamp(_raise ? maxIterations * 2 : maxIterations / 2, MIN_MAX_ITERATIONS, MAX_MAX_ITERATIONS);
+	cout << "Iteration limit " << maxIterations << (adaptiveIterations ? " (adaptive)." : ".") << endl;
+	signalRecalculation();
+}
+
+/* Turns raising the iteration limit with the zoom depth on or off, and recalculates */
+void toggleAdaptiveIterations()
+{
+	adaptiveIterations = !adaptiveIterations;
+	cout << (adaptiveIterations ? "Iteration limit raised with the zoom." : "Fixed iteration limit.") << endl;
+	signalRecalculation();
+}
+
+/* Doubles the render resolution with '_raise', halves it otherwise, and recalculates */
+void scaleRenderResolution(bool _raise)
+{
+	renderScale = std::clamp(_raise ? renderScale * 2.0 : renderScale / 2.0, MIN_RENDER_SCALE, MAX_RENDER_SCALE);
+	cout << "Rendering at " << renderScale * 100.0 << "% of the window resolution." << endl;
+	signalRecalculation();
+}
+
+/*** ~ TILE CACHE ~ ***/
+
+/* Appends '_value' to '_bytes' as a varint, 7 bits to a byte starting with the lowest, the top bit set on all but the last */
+void putVarint(vector<uint8_t>& _bytes, uint64_t _value)
+{
+	while (_value >= 0x80)
+	{
+		_bytes.push_back((uint8_t)(_value | 0x80));
+		_value >>= 7;
+	}
+	_bytes.push_back((uint8_t)_value);
+}
+
+/* Reads a varint at '_data' and moves past it. Returns false if the bytes end at '_end' before it does */
+bool getVarint(const uint8_t*& _data, const uint8_t* _end, uint64_t& _value)
+{
+	_value = 0;
+	for (int shift = 0; shift < 64 && _data < _end; shift += 7)
+	{
+		uint8_t byte = *_data++;
+		_value |= (uint64_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) return true;
+	}
+	return false;
+}
+
+/* Reads a varint at '_offset' of '_bytes' and moves past it. Returns false if the bytes end before it does */
+bool getVarint(const vector<uint8_t>& _bytes, size_t& _offset, uint64_t& _value)
+{
+	const uint8_t* data = _bytes.data() + _offset;
+	bool read = getVarint(data, _bytes.data() + _bytes.size(), _value);
+	_offset = data - _bytes.data();
+	return read;
+}
+
+/* Reads a varint like 'getVarint', and checks that it is between '_min' and '_max' */
+bool getVarint(const vector<uint8_t>& _bytes, size_t& _offset, int& _value, int _min, int _max)
+{
+	uint64_t value = 0;
+	if (!getVarint(_bytes, _offset, value) || value < (uint64_t)_min || value > (uint64_t)_max) return false;
+	_value = (int)value;
+	return true;
+}
+
+/* Appends '_size' bytes at '_data' to '_bytes' as they are */
+void putBytes(vector<uint8_t>& _bytes, const void* _data, size_t _size)
+{
+	_bytes.insert(_bytes.end(), (const uint8_t*)_data, (const uint8_t*)_data + _size);
+}
+
+/* Reads '_size' bytes at '_offset' of '_bytes' into '_data' and moves past them. Returns false if there are not as many */
+bool getBytes(const vector<uint8_t>& _bytes, size_t& _offset, void* _data, size_t _size)
+{
+	if (_bytes.size() - _offset < _size) return false;
+	memcpy(_data, &_bytes[_offset], _size);
+	_offset += _size;
+	return true;
+}
+
+/* Appends the iteration counts and escape fractions of a rectangle of a buffer to '_bytes', compressed. Neighbouring
+pixels mostly have close counts, and fractions with the same sign, exponent and top bits of the mantissa. So each count
+is stored as the varint of the zigzag encoded difference to the count before, and each fraction as the varint of its
+bits XOR the bits of the fraction before. Lossless, the pixels of the benchmark views take 2 to 4.5 bytes instead of 8.
+Used for the tiles of iteration maps and of the render farm */
+void encodeTile(const MclIterationBuffer& _iterations, const MclBuffer<float>& _fractions, int _startX, int _endX, int _startY, int _endY, vector<uint8_t>& _bytes)
+{
+	uint32_t previous = 0, previousBits = 0;
+	for (int y = _startY; y < _endY; y++)
+	{
+		const uint32_t* row = _iterations.row(y);
+		const float* fractionRow = _fractions.row(y);
+		for (int x = _startX; x < _endX; x++)
+		{
+			int64_t difference = (int64_t)row[x] - previous;
+			uint32_t bits;
+			memcpy(&bits, &fractionRow[x], sizeof(bits));
+			putVarint(_bytes, ((uint64_t)difference << 1) ^ (uint64_t)(difference >> 63));
+			putVarint(_bytes, bits ^ previousBits);
+			previous = row[x];
+			previousBits = bits;
+		}
+	}
+}
+
+/* Reads the '_count' pixels of a tile written by 'encodeTile' at '_data' into '_iterations' and '_fractions', row by row,
+and moves past them. Returns false if the bytes end at '_end' before they do */
+bool decodeTile(const uint8_t*& _data, const uint8_t* _end, int _count, uint32_t* _iterations, float* _fractions)
+{
+	uint32_t previous = 0, previousBits = 0;
+	for (int i = 0; i < _count; i++)
+	{
+		uint64_t difference = 0, bits = 0;
+		if (!getVarint(_data, _end, difference) || !getVarint(_data, _end, bits)) return false;
+		previous = (uint32_t)((int64_t)previous + (int64_t)((difference >> 1) ^ (0 - (difference & 1))));
+		previousBits ^= (uint32_t)bits;
+		_iterations[i] = previous;
+		memcpy(&_fractions[i], &previousBits, sizeof(float));
+	}
+	return true;
+}
+
+/* Gets the key of a tile of a frame of '_view' computed with the kernel '_kernelIndex' */
+MclTileKey getTileKey(const MclView& _view, int _kernelIndex, int _tileId)
+{
+	int startX, endX, startY, endY;
+	getTileBounds(_view, _tileId, startX, endX, startY, endY);
+	MclTileKey key;
+	key.left = toBigFixed(_view.exactLeft, startX, _view.pixelWidth);
+	key.top = toBigFixed(_view.exactTop, startY, _view.pixelHeight);
+	key.pixelWidth = _view.pixelWidth;
+	key.pixelHeight = _view.pixelHeight;
+	key.width = endX - startX;
+	key.height = endY - startY;
+	key.maxIterations = _view.maxIterations;
+	key.kernelIndex = _kernelIndex;
+	key.interiorChecks = _view.interiorChecks;
+	key.fractal = _view.fractal;
+	return key;
+}
+
+/* Checks if two keys are for the same tile */
+bool isSameTile(const MclTileKey& _a, const MclTileKey& _b)
+{
+	return memcmp(_a.left.limb, _b.left.limb, sizeof(_a.left.limb)) == 0 && memcmp(_a.top.limb, _b.top.limb, sizeof(_a.top.limb)) == 0
+		&& _a.pixelWidth == _b.pixelWidth && _a.pixelHeight == _b.pixelHeight && _a.width == _b.width && _a.height == _b.height
+		&& _a.maxIterations == _b.maxIterations && _a.kernelIndex == _b.kernelIndex && _a.interiorChecks == _b.interiorChecks
+		&& isSameFractal(_a.fractal, _b.fractal);
+}
+
+/* 64 bit FNV-1a hash of every field of a tile key, never 0 */
+uint64_t hashTileKey(const MclTileKey& _key)
+{
+	uint64_t hash = 14695981039346656037ull;
+	auto add = [&hash](const void* _data, size_t _size)
+	{
+		for (size_t i = 0; i < _size; i++) hash = (hash ^ ((const uint8_t*)_data)[i]) * 1099511628211ull;
+	};
+	add(_key.left.limb, sizeof(_key.left.limb));
+	add(_key.top.limb, sizeof(_key.top.limb));
+	add(&_key.pixelWidth, sizeof(double));
+	add(&_key.pixelHeight, sizeof(double));
+	int fields[7] = { _key.width, _key.height, _key.maxIterations, _key.kernelIndex, _key.interiorChecks, _key.fractal.formula, _key.fractal.power };
+	add(fields, sizeof(fields));
+	add(&_key.fractal.juliaR, sizeof(double));
+	add(&_key.fractal.juliaI, sizeof(double));
+	return hash != 0 ? hash : 1;
+}
+
+// bytes of the tile store file before the first slot, and of each slot
+const size_t TILE_STORE_HEADER_SIZE = 64;
+const size_t TILE_STORE_SLOT_SIZE = sizeof(MclTileStoreSlot) + (sizeof(uint32_t) + sizeof(float)) * TILE_SIZE * TILE_SIZE;
+
+// first bytes of a tile store file. Files made with different slot layouts are cleared when opened
+const char TILE_STORE_MAGIC[16] = "MCL TILES 3";
+
+// first bytes of an iteration map file, see 'createIterationMap'
+const char MAP_MAGIC[16] = "MCL MAP 2";
+
+/* Gets slot '_slot' of the tile store */
+MclTileStoreSlot* getTileStoreSlot(size_t _slot)
+{
+	return (MclTileStoreSlot*)(tileStore.data + TILE_STORE_HEADER_SIZE + _slot * TILE_STORE_SLOT_SIZE);
+}
+
+/* Opens the tile store file TILE_STORE_PATH, creating it if needed, and maps it into memory.
+The cache keeps working in memory only if it cannot be opened */
+void openTileStore()
+{
+	try
+	{
+		if (TILE_STORE_SLOTS == 0) return;
+		uint64_t size = TILE_STORE_HEADER_SIZE + (uint64_t)TILE_STORE_SLOTS * TILE_STORE_SLOT_SIZE;
+		tileStore.file = CreateFileA(TILE_STORE_PATH, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (tileStore.file != INVALID_HANDLE_VALUE) tileStore.mapping = CreateFileMappingA(tileStore.file, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, NULL);
+		if (tileStore.mapping) tileStore.data = (uint8_t*)MapViewOfFile(tileStore.mapping, FILE_MAP_ALL_ACCESS, 0, 0, (size_t)size);
+		if (!tileStore.data)
+		{
+			cout << "Cannot open the tile store " << TILE_STORE_PATH << ", tiles are only cached in memory." << endl;
+			return;
+		}
+
+		// the slot layout depends on TILE_SIZE, BIGFIXED_LIMBS and the kernel list of this build
+		uint32_t layout[3] = { TILE_SIZE, BIGFIXED_LIMBS, KERNEL_COUNT };
+		if (memcmp(tileStore.data, TILE_STORE_MAGIC, sizeof(TILE_STORE_MAGIC)) != 0 || memcmp(tileStore.data + sizeof(TILE_STORE_MAGIC), layout, sizeof(layout)) != 0)
+		{
+			for (size_t i = 0; i < TILE_STORE_SLOTS; i++) getTileStoreSlot(i)->key.width = 0;
+			memcpy(tileStore.data, TILE_STORE_MAGIC, sizeof(TILE_STORE_MAGIC));
+			memcpy(tileStore.data + sizeof(TILE_STORE_MAGIC), layout, sizeof(layout));
+		}
+	}
+	catch (const exception& e) { cout << "ERROR (openTileStore)\n" << e.what() << endl; }
+}
+
+/* Unmaps and closes the tile store file, the system writes back the changed slots */
+void closeTileStore()
+{
+	if (tileStore.data) UnmapViewOfFile(tileStore.data);
+	if (tileStore.mapping) CloseHandle(tileStore.mapping);
+	if (tileStore.file != INVALID_HANDLE_VALUE) CloseHandle(tileStore.file);
+	tileStore = MclTileStore();
+}
+
+/* Unmaps and closes the iteration map file */
+void closeIterationMap()
+{
+	if (iterationMap.data) UnmapViewOfFile((void*)iterationMap.data);
+	if (iterationMap.mapping) CloseHandle(iterationMap.mapping);
+	if (iterationMap.file != INVALID_HANDLE_VALUE) CloseHandle(iterationMap.file);
+	iterationMap = MclIterationMap();
+}
+
+/* Opens the iteration map file '_path' and maps it into memory read only. Nothing is read but the header and,
+when frames need them, the offsets and bytes of single tiles. Returns false if it is not a complete map of this build */
+bool openIterationMap(const std::string& _path)
+{
+	try
+	{
+		iterationMap.file = CreateFileA(_path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		LARGE_INTEGER size = {};
+		if (iterationMap.file != INVALID_HANDLE_VALUE && GetFileSizeEx(iterationMap.file, &size) && (uint64_t)size.QuadPart >= sizeof(MclMapHeader))
+		{
+			iterationMap.mapping = CreateFileMappingA(iterationMap.file, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (iterationMap.mapping) iterationMap.data = (const uint8_t*)MapViewOfFile(iterationMap.mapping, FILE_MAP_READ, 0, 0, (size_t)size.QuadPart);
+		}
+		if (!iterationMap.data)
+		{
+			cout << "Cannot open the iteration map '" << _path << "'." << endl;
+			closeIterationMap();
+			return false;
+		}
+
+		const MclMapHeader* header = (const MclMapHeader*)iterationMap.data;
+		MclView& map = iterationMap.view;
+		map.width = header->width;
+		map.height = header->height;
+		uint64_t tileCount = header->width > 0 && header->height > 0 ? (uint64_t)getTileCount(map) : 0;
+		bool valid = memcmp(header->magic, MAP_MAGIC, sizeof(MAP_MAGIC)) == 0 && header->layout[0] == TILE_SIZE && header->layout[1] == BIGFIXED_LIMBS
+			&& tileCount > 0 && header->indexOffset >= sizeof(MclMapHeader) && header->indexOffset % sizeof(uint64_t) == 0
+			&& (uint64_t)size.QuadPart >= header->indexOffset && ((uint64_t)size.QuadPart - header->indexOffset) / sizeof(uint64_t) >= tileCount + 1
+			&& header->precision >= PRECISION_FLOAT && header->precision <= PRECISION_PERTURBATION
+			&& header->formula >= 0 && header->formula < FORMULA_COUNT && header->power >= 2 && header->power <= MAX_POWER;
+		if (!valid)
+		{
+			cout << "'" << _path << "' is not a complete iteration map of this build." << endl;
+			closeIterationMap();
+			return false;
+		}
+		iterationMap.header = header;
+		iterationMap.index = (const uint64_t*)(iterationMap.data + header->indexOffset);
+		map.exactLeft = header->exactLeft;
+		map.exactTop = header->exactTop;
+		map.left = toDoubleDouble(map.exactLeft);
+		map.top = toDoubleDouble(map.exactTop);
+		map.pixelWidth = header->pixelWidth;
+		map.pixelHeight = header->pixelHeight;
+		map.maxIterations = header->maxIterations;
+		map.interiorChecks = header->interiorChecks != 0;
+		map.fractal.formula = header->formula;
+		map.fractal.power = header->power;
+		map.fractal.juliaR = header->juliaR;
+		map.fractal.juliaI = header->juliaI;
+		cout << "Opened the " << map.width << "x" << map.height << " pixel iteration map '" << _path << "' (" << map.maxIterations << " iterations, "
+			<< (double)size.QuadPart / ((double)map.width * map.height) << " bytes per pixel)." << endl;
+		return true;
+	}
+	catch (const exception& e) { cout << "ERROR (openIterationMap)\n" << e.what() << endl; }
+	return false;
+}
+
+/* Adds a tile to the front of the cache in memory, dropping the least recently used tiles past TILE_CACHE_MEGABYTES */
+void addCachedTile(const MclTileKey& _key, uint64_t _hash, vector<uint32_t> _iterations, vector<float> _fractions)
+{
+	const size_t pixelBytes = sizeof(uint32_t) + sizeof(float);
+	auto found = tileCache.index.find(_hash);
+	if (found != tileCache.index.end())
+	{
+		tileCache.bytes -= found->second->iterations.size() * pixelBytes;
+		tileCache.entries.erase(found->second);
+	}
+	MclTileCacheEntry entry;
+	entry.key = _key;
+	entry.hash = _hash;
+	entry.iterations = std::move(_iterations);
+	entry.fractions = std::move(_fractions);
+	tileCache.bytes += entry.iterations.size() * pixelBytes;
+	tileCache.entries.push_front(std::move(entry));
+	tileCache.index[_hash] = tileCache.entries.begin();
+	while (tileCache.bytes > (size_t)TILE_CACHE_MEGABYTES << 20)
+	{
+		MclTileCacheEntry& oldest = tileCache.entries.back();
+		tileCache.bytes -= oldest.iterations.size() * pixelBytes;
+		tileCache.index.erase(oldest.hash);
+		tileCache.entries.pop_back();
+	}
+}
+
+/* Looks a tile up in memory only. Returns its entry, valid until the cache changes, or nullptr */
+const MclTileCacheEntry* findTileInMemory(const MclTileKey& _key, uint64_t _hash)
+{
+	auto found = tileCache.index.find(_hash);
+	if (found == tileCache.index.end() || !isSameTile(found->second->key, _key)) return nullptr;
+	tileCache.entries.splice(tileCache.entries.begin(), tileCache.entries, found->second);
+	return &tileCache.entries.front();
+}
+
+/* Gets tile ('_tileX', '_tileY') of the iteration map, decoding it into the cache under its key in the map's view
+with the kernel '_kernelIndex' the first time. Returns nullptr if its bytes are damaged */
+const MclTileCacheEntry* getMapTile(int _tileX, int _tileY, int _kernelIndex)
+{
+	int tileId = _tileY * getTileColumns(iterationMap.view) + _tileX;
+	MclTileKey key = getTileKey(iterationMap.view, _kernelIndex, tileId);
+	uint64_t hash = hashTileKey(key);
+	const MclTileCacheEntry* cached = findTileInMemory(key, hash);
+	if (cached) return cached;
+
+	uint64_t start = iterationMap.index[tileId], end = iterationMap.index[tileId + 1];
+	if (start < sizeof(MclMapHeader) || start > end || end > iterationMap.header->indexOffset) return nullptr;
+	const uint8_t* data = iterationMap.data + start;
+	vector<uint32_t> iterations((size_t)key.width * key.height);
+	vector<float> fractions(iterations.size());
+	if (!decodeTile(data, iterationMap.data + end, key.width * key.height, iterations.data(), fractions.data())) return nullptr;
+	addCachedTile(key, hash, std::move(iterations), std::move(fractions));
+	return &tileCache.entries.front();
+}
+
+/* Looks a tile up in the iteration map. The map has it if the tile lies inside it, a whole number of pixels from the
+top left, at the same pixel size and iteration limit, and the map was computed at least as precisely. The tile is
+copied together from the up to four tiles of the map it overlaps, so frames panned by any number of pixels or resized
+still come from the map. Returns its entry like 'findCachedTile', or nullptr */
+const MclTileCacheEntry* findMapTile(const MclTileKey& _key, uint64_t _hash)
+{
+	if (!iterationMap.data) return nullptr;
+	const MclView& map = iterationMap.view;
+	if (_key.pixelWidth != map.pixelWidth || _key.pixelHeight != map.pixelHeight || _key.maxIterations != map.maxIterations
+		|| _key.interiorChecks != map.interiorChecks || !isSameFractal(_key.fractal, map.fractal) || kernelArray[_key.kernelIndex].precision > iterationMap.header->precision) return nullptr;
+	double x = toDouble(_key.left - map.exactLeft) / map.pixelWidth, y = toDouble(_key.top - map.exactTop) / map.pixelHeight;
+	if (!(x > -0.5 && x + _key.width < map.width + 0.5 && y > -0.5 && y + _key.height < map.height + 0.5)) return nullptr;
+	int startX = (int)lround(x), startY = (int)lround(y);
+	if (fabs(x - startX) > 1e-6 || fabs(y - startY) > 1e-6) return nullptr;
+
+	vector<uint32_t> iterations((size_t)_key.width * _key.height);
+	vector<float> fractions(iterations.size());
+	for (int tileY = startY / TILE_SIZE; tileY * TILE_SIZE < startY + _key.height; tileY++)
+	{
+		for (int tileX = startX / TILE_SIZE; tileX * TILE_SIZE < startX + _key.width; tileX++)
+		{
+			const MclTileCacheEntry* source = getMapTile(tileX, tileY, _key.kernelIndex);
+			if (!source) return nullptr;
+			int fromX = std::max(startX, tileX * TILE_SIZE), toX = std::min(startX + _key.width, tileX * TILE_SIZE + source->key.width);
+			int fromY = std::max(startY, tileY * TILE_SIZE), toY = std::min(startY + _key.height, tileY * TILE_SIZE + source->key.height);
+			for (int pixelY = fromY; pixelY < toY; pixelY++)
+			{
+				size_t target = (size_t)(pixelY - startY) * _key.width + fromX - startX;
+				size_t sourceOffset = (size_t)(pixelY - tileY * TILE_SIZE) * source->key.width + fromX - tileX * TILE_SIZE;
+				memcpy(&iterations[target], &source->iterations[sourceOffset], sizeof(uint32_t) * (toX - fromX));
+				memcpy(&fractions[target], &source->fractions[sourceOffset], sizeof(float) * (toX - fromX));
+			}
+		}
+	}
+	addCachedTile(_key, _hash, std::move(iterations), std::move(fractions));
+	return &tileCache.entries.front();
+}
+
+/* Looks a tile up in memory, then in the tile store, then in the iteration map. Returns its entry, valid until the cache
+changes, or nullptr if it is not cached. Tiles found on disk are moved into memory */
+const MclTileCacheEntry* findCachedTile(const MclTileKey& _key, uint64_t _hash)
+{
+	const MclTileCacheEntry* cached = findTileInMemory(_key, _hash);
+	if (cached) return cached;
+	if (tileStore.data)
+	{
+		MclTileStoreSlot* slot = getTileStoreSlot(_hash % TILE_STORE_SLOTS);
+		if (slot->hash == _hash && isSameTile(slot->key, _key))
+		{
+			const uint32_t* storedIterations = (const uint32_t*)(slot + 1);
+			const float* storedFractions = (const float*)(storedIterations + TILE_SIZE * TILE_SIZE);
+			int pixelCount = _key.width * _key.height;
+			addCachedTile(_key, _hash, vector<uint32_t>(storedIterations, storedIterations + pixelCount), vector<float>(storedFractions, storedFractions + pixelCount));
+			return &tileCache.entries.front();
+		}
+	}
+	return findMapTile(_key, _hash);
+}
+
+/* Fills the tiles marked in '_needed' which are in the cache into the back buffer, publishes them for '_epoch'
+right away and clears them in '_needed'. Returns the number of tiles filled. Must only be called by the main thread before the tiles of '_epoch' are submitted */
+int fetchCachedTiles(const MclView& _view, int _kernelIndex, uint32_t _epoch, vector<bool>& _needed)
+{
+	int fetched = 0;
+	for (int tileId = 0; tileId < getTileCount(_view); tileId++)
+	{
+		if (!_needed[tileId]) continue;
+		MclTileKey key = getTileKey(_view, _kernelIndex, tileId);
+		const MclTileCacheEntry* cached = findCachedTile(key, hashTileKey(key));
+		if (!cached) continue;
+		int startX, endX, startY, endY;
+		getTileBounds(_view, tileId, startX, endX, startY, endY);
+		enterTile(tileId, _epoch);
+		for (int y = startY; y < endY; y++)
+		{
+			memcpy(pixels.row(y) + startX, &cached->iterations[(y - startY) * key.width], sizeof(uint32_t) * key.width);
+			memcpy(fractionPixels.row(y) + startX, &cached->fractions[(y - startY) * key.width], sizeof(float) * key.width);
+		}
+		tileStampArray[tileId].store(getTileStamp(_epoch, 1), std::memory_order_release);
+		leaveTile(tileId);
+		_needed[tileId] = false;
+		fetched++;
+	}
+	if (fetched > 0) damageDisplay();
+	return fetched;
+}
+
+/* Adds the tiles marked in '_computed' to the cache and the tile store, if the last pass of frame '_epoch' finished them.
+Must only be called by the main thread while the workers are idle */
+void storeFinishedTiles(const MclView& _view, int _kernelIndex, uint32_t _epoch, const vector<bool>& _computed)
+{
+	for (int tileId = 0; tileId < getTileCount(_view); tileId++)
+	{
+		if (!_computed[tileId] || !isTileFinished(tileStampArray[tileId].load(std::memory_order_acquire), _epoch)) continue;
+		MclTileKey key = getTileKey(_view, _kernelIndex, tileId);
+		uint64_t hash = hashTileKey(key);
+		int startX, endX, startY, endY;
+		getTileBounds(_view, tileId, startX, endX, startY, endY);
+		vector<uint32_t> iterations((size_t)key.width * key.height);
+		vector<float> fractions(iterations.size());
+		for (int y = startY; y < endY; y++)
+		{
+			memcpy(&iterations[(y - startY) * key.width], pixels.row(y) + startX, sizeof(uint32_t) * key.width);
+			memcpy(&fractions[(y - startY) * key.width], fractionPixels.row(y) + startX, sizeof(float) * key.width);
+		}
+		if (tileStore.data)
+		{
+			MclTileStoreSlot* slot = getTileStoreSlot(hash % TILE_STORE_SLOTS);
+			uint32_t* storedIterations = (uint32_t*)(slot + 1);
+			slot->hash = hash;
+			slot->key = key;
+			memcpy(storedIterations, iterations.data(), iterations.size() * sizeof(uint32_t));
+			memcpy(storedIterations + TILE_SIZE * TILE_SIZE, fractions.data(), fractions.size() * sizeof(float));
+		}
+		addCachedTile(key, hash, std::move(iterations), std::move(fractions));
+	}
+}
+
+/* Adds the tiles the workers prefetched to the cache. Must only be called by the main thread */
+int takePrefetchedTiles()
+{
+	vector<MclTileCacheEntry> tiles;
+	{
+		unique_lock<mutex> lk(prefetchMutex);
+		tiles.swap(prefetchedTiles);
+	}
+	for (MclTileCacheEntry& tile : tiles) addCachedTile(tile.key, tile.hash, std::move(tile.iterations), std::move(tile.fractions));
+	return (int)tiles.size();
+}
+
+/* Queues speculative jobs for the tiles of the frame a click at the cursor would zoom into which are not cached yet,
+for views of generation '_generation'. They are dropped when the view changes or the cursor moves again.
+Returns the number of tiles queued */
+int submitPrefetchTiles(uint32_t _generation, uint32_t _hover, int _workerCount)
+{
+	MclView zoomed;
+	if (!getCursorZoomView(zoomed)) return 0;
+	MclView target = getFrameView(zoomed, _generation);
+	int kernelIndex = getKernelForView(target);
+	if (kernelArray[kernelIndex].precision == PRECISION_PERTURBATION) target.references = createReferenceSet(target);
+
+	int queued = 0;
+	for (int tileId = 0; tileId < getTileCount(target); tileId++)
+	{
+		MclTileKey key = getTileKey(target, kernelIndex, tileId);
+		if (findCachedTile(key, hashTileKey(key))) continue;
+		int startX, endX, startY, endY;
+		getTileBounds(target, tileId, startX, endX, startY, endY);
+		MclJob job(kernelArray[kernelIndex].function, target, 0, startX, endX, startY, endY);
+		job.prefetchKernelIndex = kernelIndex;
+		job.hoverGeneration = _hover;
+		submitJob(queued++ % _workerCount, job);
+	}
+	return queued;
+}
+
+/* Waits like 'waitForRenderRequest', and keeps the idle workers busy with the view a left click would zoom into once
+the cursor rested for PREFETCH_HOVER_DELAY. Wakes up for cursor moves only, it does not poll. Returns when the view of
+generation '_generation' went stale, which drops the speculative jobs which are left so the new frame has the workers to
+itself. The tiles are added to the cache when it wakes up, and by the next frame. Must only be called by the main thread */
+void prefetchWhileIdle(uint32_t _generation, int _workerCount)
+{
+	unique_lock<mutex> lk(renderRequestMutex);
+	uint32_t lastHover = hoverGeneration, prefetched = lastHover;
+	auto woken = [&] { return isStale(_generation) || windowClosed || hoverGeneration != lastHover; };
+	while (!isStale(_generation) && !windowClosed)
+	{
+		if (lastHover == prefetched) renderRequested.wait(lk, woken);
+		else if (!renderRequested.wait_for(lk, milliseconds(PREFETCH_HOVER_DELAY), woken))
+		{
+			// the cursor rested
+			prefetched = lastHover;
+			lk.unlock();
+			takePrefetchedTiles();
+			if (speculativePrefetch && tileCaching) submitPrefetchTiles(_generation, prefetched, _workerCount);
+			lk.lock();
+			continue;
+		}
+		lastHover = hoverGeneration;
+	}
+}
+
+/*** ~ GPU BACKEND ~ ***/
+
+// fragment shader of the GPU backend. Computes one pixel per fragment, the pixel position comes from gl_FragCoord.
+// Compiled as is (float) or with EMULATED_DOUBLE defined, which iterates in float-float pairs (about 48 bits).
+// PRECISE marks the error-free transforms of the float-float arithmetic, see 'createGpuBackend'
+const char* GPU_SHADER_SOURCE = R"(
+uniform vec2 uLeft, uTop, uPixelWidth, uPixelHeight; // (hi, lo) pairs, only hi is used by the float variant
+uniform int uMaxIterations;
+uniform bool uInteriorChecks;
+
+vec2 quickTwoSum(float a, float b) { PRECISE float s = a + b; PRECISE float e = b - (s - a); return vec2(s, e); }
+vec2 twoSum(float a, float b)
+{
+	PRECISE float s = a + b;
+	PRECISE float v = s - a;
+	PRECISE float e = (a - (s - v)) + (b - v);
+	return vec2(s, e);
+}
+vec2 split(float a) { PRECISE float t = a * 4097.0; PRECISE float hi = t - (t - a); PRECISE float lo = a - hi; return vec2(hi, lo); }
+vec2 twoProd(float a, float b)
+{
+	PRECISE float p = a * b;
+	vec2 as = split(a), bs = split(b);
+	PRECISE float e = ((as.x * bs.x - p) + as.x * bs.y + as.y * bs.x) + as.y * bs.y;
+	return vec2(p, e);
+}
+vec2 dfAdd(vec2 a, vec2 b) { vec2 s = twoSum(a.x, b.x); PRECISE float lo = s.y + (a.y + b.y); return quickTwoSum(s.x, lo); }
+vec2 dfMul(vec2 a, vec2 b) { vec2 p = twoProd(a.x, b.x); PRECISE float lo = p.y + (a.x * b.y + a.y * b.x); return quickTwoSum(p.x, lo); }
+
+bool isInMainBulbs(float cr, float ci)
+{
+	float xq = cr - 0.25, y2 = ci * ci;
+	float q = xq * xq + y2;
+	if (q * (q + xq) <= 0.25 * y2) return true;
+	float xb = cr + 1.0;
+	return xb * xb + y2 <= 0.0625;
+}
+
+void main()
+{
+	vec2 pixel = floor(gl_FragCoord.xy);
+	int iterations = 0;
+#ifdef EMULATED_DOUBLE
+	vec2 cr = dfAdd(uLeft, dfMul(vec2(pixel.x, 0.0), uPixelWidth)), ci = dfAdd(uTop, dfMul(vec2(pixel.y, 0.0), uPixelHeight));
+	if (uInteriorChecks && isInMainBulbs(cr.x, ci.x)) iterations = uMaxIterations;
+	vec2 zr = vec2(0.0), zi = vec2(0.0), zr2 = vec2(0.0), zi2 = vec2(0.0);
+	for (; iterations < uMaxIterations && zr2.x + zi2.x < 4.0; iterations++)
+	{
+		zi = dfAdd(dfMul(zr * 2.0, zi), ci);
+		zr = dfAdd(dfAdd(zr2, -zi2), cr);
+		zr2 = dfMul(zr, zr);
+		zi2 = dfMul(zi, zi);
+	}
+#else
+	float cr = uLeft.x + pixel.x * uPixelWidth.x, ci = uTop.x + pixel.y * uPixelHeight.x;
+	if (uInteriorChecks && isInMainBulbs(cr, ci)) iterations = uMaxIterations;
+	float zr = 0.0, zi = 0.0, zr2 = 0.0, zi2 = 0.0;
+	for (; iterations < uMaxIterations && zr2 + zi2 < 4.0; iterations++)
+	{
+		zi = 2.0 * zr * zi + ci;
+		zr = zr2 - zi2 + cr;
+		zr2 = zr * zr;
+		zi2 = zi * zi;
+	}
+#endif
+	if (iterations >= uMaxIterations) gl_FragColor = vec4(1.0);
+	else
+	{
+		float q = float(iterations) / float(uMaxIterations);
+		gl_FragColor = vec4(q, 0.0, q, 1.0);
+	}
+}
+)";
+
+/* Name of a backend, for the performance measurements */
+const char* getBackendName(int _backend)
+{
+	if (_backend == BACKEND_GPU_FLOAT) return "GPU float shader";
+	if (_backend == BACKEND_GPU_DOUBLE) return "GPU emulated double shader";
+	return "CPU";
+}
+
+/* Looks up an OpenGL entry point of the current context. Returns false if the driver does not have it */
+template <typename T>
+bool loadGlFunction(T& _function, const char* _name)
+{
+	_function = (T)glfwGetProcAddress(_name);
+	return _function != nullptr;
+}
+
+/* Loads the GL 2.0 and framebuffer object functions used by the GPU backend */
+bool loadGpuFunctions(MclGpuFunctions& _gl)
+{
+	return loadGlFunction(_gl.createShader, "glCreateShader") && loadGlFunction(_gl.shaderSource, "glShaderSource")
+		&& loadGlFunction(_gl.compileShader, "glCompileShader") && loadGlFunction(_gl.getShaderiv, "glGetShaderiv")
+		&& loadGlFunction(_gl.getShaderInfoLog, "glGetShaderInfoLog") && loadGlFunction(_gl.deleteShader, "glDeleteShader")
+		&& loadGlFunction(_gl.createProgram, "glCreateProgram") && loadGlFunction(_gl.attachShader, "glAttachShader")
+		&& loadGlFunction(_gl.linkProgram, "glLinkProgram") && loadGlFunction(_gl.getProgramiv, "glGetProgramiv")
+		&& loadGlFunction(_gl.getProgramInfoLog, "glGetProgramInfoLog") && loadGlFunction(_gl.deleteProgram, "glDeleteProgram")
+		&& loadGlFunction(_gl.useProgram, "glUseProgram") && loadGlFunction(_gl.getUniformLocation, "glGetUniformLocation")
+		&& loadGlFunction(_gl.uniform1i, "glUniform1i") && loadGlFunction(_gl.uniform2f, "glUniform2f")
+		&& loadGlFunction(_gl.genFramebuffers, "glGenFramebuffers") && loadGlFunction(_gl.bindFramebuffer, "glBindFramebuffer")
+		&& loadGlFunction(_gl.framebufferTexture2D, "glFramebufferTexture2D") && loadGlFunction(_gl.checkFramebufferStatus, "glCheckFramebufferStatus")
+		&& loadGlFunction(_gl.deleteFramebuffers, "glDeleteFramebuffers");
+}
+
+/* Compiles the shader for '_backend' and attaches the display texture to a framebuffer, so the shader writes into it.
+Returns false (and prints why) if the GPU or driver cannot run the backend. Must be called from the rendering thread */
+bool createGpuBackend(MclGpuBackend& _gpu, int _backend, GLuint _texture)
+{
+	try
+	{
+		MclGpuFunctions& gl = _gpu.gl;
+		if (!loadGpuFunctions(gl)) { cout << "The GPU backend needs OpenGL 3.0 or framebuffer objects." << endl; return false; }
+
+		// GLSL 4.00 has 'precise', which stops the compiler from optimising away the rounding errors the emulated double arithmetic
+		// relies on. Older GPUs get GLSL 1.20, where the emulated double variant may be no more precise than float
+		const char* versions[] = { "#version 400 compatibility\n#define PRECISE precise\n", "#version 120\n#define PRECISE\n" };
+		GLuint shader = 0;
+		GLint status = 0;
+		char log[1024] = "";
+		for (const char* version : versions)
+		{
+			const char* sources[] = { version, _backend == BACKEND_GPU_DOUBLE ? "#define EMULATED_DOUBLE\n" : "", GPU_SHADER_SOURCE };
+			shader = gl.createShader(GL_FRAGMENT_SHADER);
+			gl.shaderSource(shader, 3, sources, NULL);
+			gl.compileShader(shader);
+			gl.getShaderiv(shader, GL_COMPILE_STATUS, &status);
+			if (status) break;
+			gl.getShaderInfoLog(shader, sizeof(log), NULL, log);
+			gl.deleteShader(shader);
+		}
+		if (!status) { cout << "The GPU shader did not compile:\n" << log << endl; return false; }
+
+		_gpu.program = gl.createProgram();
+		gl.attachShader(_gpu.program, shader);
+		gl.linkProgram(_gpu.program);
+		gl.deleteShader(shader);
+		gl.getProgramiv(_gpu.program, GL_LINK_STATUS, &status);
+		if (!status)
+		{
+			gl.getProgramInfoLog(_gpu.program, sizeof(log), NULL, log);
+			cout << "The GPU shader did not link:\n" << log << endl;
+			return false;
+		}
+		_gpu.leftLocation = gl.getUniformLocation(_gpu.program, "uLeft");
+		_gpu.topLocation = gl.getUniformLocation(_gpu.program, "uTop");
+		_gpu.pixelWidthLocation = gl.getUniformLocation(_gpu.program, "uPixelWidth");
+		_gpu.pixelHeightLocation = gl.getUniformLocation(_gpu.program, "uPixelHeight");
+		_gpu.maxIterationsLocation = gl.getUniformLocation(_gpu.program, "uMaxIterations");
+		_gpu.interiorChecksLocation = gl.getUniformLocation(_gpu.program, "uInteriorChecks");
+
+		gl.genFramebuffers(1, &_gpu.framebuffer);
+		gl.bindFramebuffer(GL_FRAMEBUFFER, _gpu.framebuffer);
+		gl.framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _texture, 0);
+		bool complete = gl.checkFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+		gl.bindFramebuffer(GL_FRAMEBUFFER, 0);
+		if (!complete) { cout << "The display texture cannot be rendered to." << endl; return false; }
+		return true;
+	}
+	catch (const exception& e) { cout << "ERROR (createGpuBackend)\n" << e.what() << endl; }
+	return false;
+}
+
+/* Frees the shader and framebuffer of the GPU backend */
+void destroyGpuBackend(MclGpuBackend& _gpu)
+{
+	if (_gpu.program) _gpu.gl.deleteProgram(_gpu.program);
+	if (_gpu.framebuffer) _gpu.gl.deleteFramebuffers(1, &_gpu.framebuffer);
+	_gpu.program = _gpu.framebuffer = 0;
+}
+
+/* Sets a (hi, lo) float pair uniform from a double-double */
+void setGpuUniform(MclGpuBackend& _gpu, GLint _location, MclDoubleDouble _value)
+{
+	float hi = (float)_value.hi;
+	_gpu.gl.uniform2f(_location, hi, (float)((_value.hi - hi) + _value.lo));
+}
+
+/* Marks the GPU frame as done (or abandoned) and wakes up the main thread */
+void finishGpuFrame()
+{
+	{
+		unique_lock<mutex> lk(gpuFrameMutex);
+		gpuFramePending = false;
+	}
+	gpuFrameFinished.notify_all();
+}
+
+/* Runs the shader over the next row of tiles of the pending GPU frame, if there is one. A frame is split up
+into rows so that the window stays responsive and a new view can cancel it. Returns true if the texture changed */
+bool stepGpuFrame(MclGpuBackend& _gpu, MclDisplayTexture& _texture)
+{
+	MclView frameView;
+	{
+		unique_lock<mutex> lk(gpuFrameMutex);
+		if (!gpuFramePending) return false;
+		frameView = gpuFrameView;
+	}
+	if (isStale(frameView.generation)) { _gpu.nextTileRow = 0; finishGpuFrame(); return false; }
+
+	MclGpuFunctions& gl = _gpu.gl;
+	if (_gpu.nextTileRow == 0) fitDisplayTexture(_texture, frameView);
+	gl.bindFramebuffer(GL_FRAMEBUFFER, _gpu.framebuffer);
+	glViewport(0, 0, frameView.width, frameView.height);
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glOrtho(0, frameView.width, 0, frameView.height, 0, 1); // framebuffer row y is texture row y, which is drawn as window row y
+	if (_gpu.nextTileRow == 0) glClear(GL_COLOR_BUFFER_BIT);
+
+	gl.useProgram(_gpu.program);
+	setGpuUniform(_gpu, _gpu.leftLocation, frameView.left);
+	setGpuUniform(_gpu, _gpu.topLocation, frameView.top);
+	setGpuUniform(_gpu, _gpu.pixelWidthLocation, MclDoubleDouble(frameView.pixelWidth));
+	setGpuUniform(_gpu, _gpu.pixelHeightLocation, MclDoubleDouble(frameView.pixelHeight));
+	gl.uniform1i(_gpu.maxIterationsLocation, frameView.maxIterations);
+	gl.uniform1i(_gpu.interiorChecksLocation, frameView.interiorChecks);
+
+	int startY = _gpu.nextTileRow * TILE_SIZE, endY = std::min(startY + TILE_SIZE, frameView.height);
+	glBegin(GL_QUADS);
+	glVertex2i(0, startY);
+	glVertex2i(frameView.width, startY);
+	glVertex2i(frameView.width, endY);
+	glVertex2i(0, endY);
+	glEnd();
+
+	gl.useProgram(0);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	gl.bindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, windowWidth, windowHeight);
+
+	if (++_gpu.nextTileRow == getTileRows(frameView))
+	{
+		glFinish(); // so the frame time measured by the main thread includes the GPU work
+		_gpu.nextTileRow = 0;
+		finishGpuFrame();
+	}
+	return true;
+}
+
+/* Hands a view to the rendering thread to compute on the GPU, and waits until it is done or cancelled.
+Also returns if the rendering thread fell back to the CPU or the window was closed */
+void computeOnGpu(const MclView& _view)
+{
+	unique_lock<mutex> lk(gpuFrameMutex);
+	gpuFrameView = _view;
+	gpuFramePending = true;
+	damageDisplay();
+	gpuFrameFinished.wait(lk, [] { return !gpuFramePending || backend == BACKEND_CPU || windowClosed; });
+	gpuFramePending = false;
+}
+
+/* Computes '_view' on the GPU straight from the calling thread, which must have the context of the backend current.
+Used by the benchmark, which has no rendering thread to hand the frame to */
+void computeGpuFrame(MclGpuBackend& _gpu, MclDisplayTexture& _texture, const MclView& _view)
+{
+	{
+		unique_lock<mutex> lk(gpuFrameMutex);
+		gpuFrameView = _view;
+		gpuFramePending = true;
+	}
+	while (stepGpuFrame(_gpu, _texture)) {}
+}
+
+/*** ~ CALLBACK FUNCTIONS ~ ***/
+
+/*  Called when the cursor is moved. Stores the cursor position into global variables. */
+void cursorPositionCallback(GLFWwindow* _window, double _x, double _y)
+{
+	// size of the cursor zoom box, dependant on the window size and scale of the cursor box
+	double boxWidth = windowWidth * CURSOR_BOX_SCALE, boxHeight = windowHeight * CURSOR_BOX_SCALE;
+
+	cursorBox[0] = _x - boxWidth;
+	cursorBox[1] = _y - boxHeight;
+
+	cursorBox[2] = _x + boxWidth;
+	cursorBox[3] = _y - boxHeight;
+
+	cursorBox[4] = _x + boxWidth;
+	cursorBox[5] = _y + boxHeight;
+
+	cursorBox[6] = _x - boxWidth;
+	cursorBox[7] = _y + boxHeight;
+
+	{
+		unique_lock<mutex> lk(renderRequestMutex);
+		hoverGeneration++;
+	}
+	renderRequested.notify_all();
+	redrawWindow = true;
+}
+
+/* Called when the window is resized. Sets up the projection for the new size and fits the view to it */
+void framebufferSizeCallback(GLFWwindow* _window, int _width, int _height)
+{
+	if (_width <= 0 || _height <= 0) return; // minimised
+	windowWidth = _width;
+	windowHeight = _height;
+	glViewport(0, 0, _width, _height);
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(0, _width, _height, 0, 0, 1);
+	glMatrixMode(GL_MODELVIEW);
+	resizeView(_width, _height);
+	redrawWindow = true;
+}
+
+/* Called when the window needs to be drawn again, such as after being uncovered */
+void windowRefreshCallback(GLFWwindow* _window)
+{
+	redrawWindow = true;
+}
+
+/* Called when the mouse is clicked. If left click, zoom in. If right click, zoom out to the default view */
+void mouseClickCallback(GLFWwindow* _window, int _butt, int _action, int _mods)
+{
+	try
+	{
+		if (_butt == GLFW_MOUSE_BUTTON_LEFT && _action == GLFW_RELEASE)
+		{
+			double zoomBoxSize = 10;
+			MclPoint TopLeft = getValueOfPixel(cursorBox[0], cursorBox[1]);
+			MclPoint BottomRight = getValueOfPixel(cursorBox[4], cursorBox[5]);
+			setZoom(TopLeft.x, BottomRight.x, TopLeft.y, BottomRight.y);
+		}
+		else if (_butt == GLFW_MOUSE_BUTTON_RIGHT && _action == GLFW_RELEASE) resetZoom();
+	}
+	catch (const exception& e) { cout << "ERROR (mouseClickCallback)\n" << e.what() << endl; }
+}
+
+void keypressCallback(GLFWwindow* _window, int _key, int _scancode, int _action, int _mods)
+{
+	if (_key == GLFW_KEY_UP && _action == GLFW_RELEASE)	setThreadCount(getThreadCount() + 1);
+	else if (_key == GLFW_KEY_DOWN && _action == GLFW_RELEASE) setThreadCount(getThreadCount() - 1);
+	else if (_key == GLFW_KEY_K && _action == GLFW_RELEASE) cycleKernel();
+	else if (_key == GLFW_KEY_P && _action == GLFW_RELEASE) togglePerturbation();
+	else if (_key == GLFW_KEY_I && _action == GLFW_RELEASE) toggleInteriorChecks();
+	else if (_key == GLFW_KEY_R && _action == GLFW_RELEASE) toggleProgressiveRendering();
+	else if (_key == GLFW_KEY_M && _action == GLFW_RELEASE) toggleSubdivision();
+	else if (_key == GLFW_KEY_E && _action == GLFW_RELEASE) toggleAntialiasing();
+	else if (_key == GLFW_KEY_N && _action == GLFW_RELEASE) toggleThreadPinning();
+	else if (_key == GLFW_KEY_J && _action == GLFW_RELEASE) cycleFormula();
+	else if (_key == GLFW_KEY_Q && _action == GLFW_RELEASE) cyclePower();
+	else if (_key == GLFW_KEY_PAGE_UP && _action == GLFW_RELEASE) scaleMaxIterations(true);
+	else if (_key == GLFW_KEY_PAGE_DOWN && _action == GLFW_RELEASE) scaleMaxIterations(false);
+	else if (_key == GLFW_KEY_L && _action == GLFW_RELEASE) toggleAdaptiveIterations();
+	else if (_key == GLFW_KEY_C && _action == GLFW_RELEASE) toggleTileCache();
+	else if (_key == GLFW_KEY_O && _action == GLFW_RELEASE) showIterationMap();
+	else if (_key == GLFW_KEY_G && _action == GLFW_RELEASE) cyclePalette();
+	else if (_key == GLFW_KEY_F && _action == GLFW_RELEASE) toggleSmoothColouring();
+	else if (_key == GLFW_KEY_H && _action == GLFW_RELEASE) toggleHistogramEqualisation();
+	else if (_key == GLFW_KEY_T && _action == GLFW_RELEASE) toggleTileHeatmap();
+	else if (_key == GLFW_KEY_X && _action == GLFW_RELEASE) toggleTraceRecording();
+	else if (_key == GLFW_KEY_Z && _action == GLFW_RELEASE) toggleSpeculativePrefetch();
+	else if (_key == GLFW_KEY_V && _action == GLFW_RELEASE) toggleVsync();
+	else if (_key == GLFW_KEY_HOME && _action == GLFW_RELEASE) scaleFrameRateCap(true);
+	else if (_key == GLFW_KEY_END && _action == GLFW_RELEASE) scaleFrameRateCap(false);
+	else if (_key == GLFW_KEY_LEFT_BRACKET && _action == GLFW_RELEASE) scaleRenderResolution(false);
+	else if (_key == GLFW_KEY_RIGHT_BRACKET && _action == GLFW_RELEASE) scaleRenderResolution(true);
+	else if (_key == GLFW_KEY_W && _action == GLFW_RELEASE) panView(0, -PAN_STEP_TILES);
+	else if (_key == GLFW_KEY_S && _action == GLFW_RELEASE) panView(0, PAN_STEP_TILES);
+	else if (_key == GLFW_KEY_A && _action == GLFW_RELEASE) panView(-PAN_STEP_TILES, 0);
+	else if (_key == GLFW_KEY_D && _action == GLFW_RELEASE) panView(PAN_STEP_TILES, 0);
+}
+
+/*** ~~~ ***/
+
+/* main rendering thread function. Handles GLFW setup calls and main rendering loop */
+void render()
+{
+	// GLFW setup
+	GLFWwindow* window;
+	try
+	{
+		if (!glfwInit()) return;
+		window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Mandelbrot", NULL, NULL);
+		glfwSetCursorPosCallback(window, cursorPositionCallback);
+		glfwSetMouseButtonCallback(window, mouseClickCallback);
+		glfwSetKeyCallback(window, keypressCallback);
+		glfwSetWindowRefreshCallback(window, windowRefreshCallback);
+		glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+		if (!window) { glfwTerminate(); return; }
+		glfwMakeContextCurrent(window);
+		glMatrixMode(GL_MODELVIEW);
+		glLoadIdentity();
+
+		// the framebuffer can be bigger than the requested window size on high DPI screens
+		int framebufferWidth = WINDOW_WIDTH, framebufferHeight = WINDOW_HEIGHT;
+		glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+		framebufferSizeCallback(window, framebufferWidth, framebufferHeight);
+	}
+	catch (const exception& e) { cout << "ERROR (GLFW setup)\n" << e.what() << endl; }
+
+	// texture holding the colours of the whole frame, drawn as one quad over the window. Tiles are uploaded to it as they change
+	MclDisplayTexture texture;
+	try
+	{
+		glGenTextures(1, &texture.id);
+		glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		fitDisplayTexture(texture, getRenderView(view));
+	}
+	catch (const exception& e) { cout << "ERROR (texture setup)\n" << e.what() << endl; }
+
+	// set up the GPU backend if it was chosen, fall back to the CPU if this GPU cannot run it
+	MclGpuBackend gpu;
+	if (backend != BACKEND_CPU && !createGpuBackend(gpu, backend, texture.id))
+	{
+		cout << "Using the CPU instead." << endl;
+		destroyGpuBackend(gpu);
+		backend = BACKEND_CPU;
+		signalRecalculation();
+		finishGpuFrame();
+	}
+
+	// frame, view and tiles currently in 'displayPixels'
+	uint32_t displayedEpoch = 0;
+	MclView displayedView;
+	vector<uint32_t> displayedTileStamps;
+
+	// tiles which changed since the last upload, and the colours of one tile for the upload
+	vector<int> dirtyTiles;
+	MclPixel tileColours[TILE_SIZE * TILE_SIZE];
+
+	// cumulative histogram of the last finished frame for histogram equalisation, with the frame and iteration limit it is of
+	vector<float> equalisation;
+	uint32_t equalisedEpoch = 0;
+	int equalisedMaxIterations = 0;
+
+	// does the window show less than the texture has? When it was last drawn, and the swap interval set for vsync
+	bool windowStale = true;
+	timer::time_point lastDrawn = timer::now();
+	int swapInterval = -1;
+
+	// Main render loop. It sleeps until something changes, and draws at most 'frameRateCap' times a second
+	try
+	{
+		while (!glfwWindowShouldClose(window))
+		{
+			if (swapInterval != (vsync ? 1 : 0))
+			{
+				swapInterval = vsync ? 1 : 0;
+				glfwSwapInterval(swapInterval);
+			}
+
+			// colour the tiles the workers have finished and upload them to the texture
+			displayDamaged = false;
+			dirtyTiles.clear();
+			if (copyFinishedTiles(displayedEpoch, displayedView, displayedTileStamps, dirtyTiles)) fitDisplayTexture(texture, displayedView);
+
+			// colour every tile again when a colour setting changed, or when a frame finished while equalising
+			bool recolour = recolourPixels.exchange(false);
+			if (histogramEqualisation && displayedEpoch != equalisedEpoch && isDisplayFinished(displayedEpoch, displayedTileStamps))
+			{
+				equalisation = getEqualisation(displayPixels, displayedView.maxIterations, getThreadCount());
+				equalisedEpoch = displayedEpoch;
+				equalisedMaxIterations = displayedView.maxIterations;
+				recolour = true;
+			}
+			if (recolour && backend == BACKEND_CPU && displayedEpoch != 0)
+			{
+				dirtyTiles.clear();
+				for (int tileId = 0; tileId < getTileCount(displayedView); tileId++) dirtyTiles.push_back(tileId);
+			}
+			bool equalise = histogramEqualisation && equalisedMaxIterations == displayedView.maxIterations;
+			MclColouring colouring = getColouring(displayedView.maxIterations, equalise ? &equalisation : nullptr);
+			for (int tileId : dirtyTiles)
+			{
+				int startX, endX, startY, endY;
+				getTileBounds(displayedView, tileId, startX, endX, startY, endY);
+				colourPixels(displayPixels, displayFractions, startX, endX, startY, endY, colouring, tileColours);
+				if (tileId < (int)displaySampleCounts.size() && displaySampleCounts[tileId] > 0) blendSamples(&displaySamples[(size_t)tileId * AA_TILE_SAMPLES], displaySampleCounts[tileId], colouring, tileColours);
+				glTexSubImage2D(GL_TEXTURE_2D, 0, startX, startY, endX - startX, endY - startY, GL_RGBA, GL_UNSIGNED_BYTE, tileColours);
+			}
+
+			// run the GPU backend over the next row of tiles
+			bool gpuChanged = backend != BACKEND_CPU && stepGpuFrame(gpu, texture);
+
+			// only draw when something changed, and not before the frame rate cap allows. Until then sleep until an event,
+			// new tiles or the next frame, but keep stepping a GPU frame
+			windowStale = windowStale || !dirtyTiles.empty() || gpuChanged || redrawWindow.exchange(false);
+			double untilNextDraw = 1.0 / frameRateCap - duration_cast<std::chrono::duration<double>>(timer::now() - lastDrawn).count();
+			if (!windowStale || untilNextDraw > 0.0)
+			{
+				if (gpuChanged) glfwPollEvents();
+				else glfwWaitEventsTimeout(windowStale ? untilNextDraw : RENDER_IDLE_TIMEOUT);
+				continue;
+			}
+			windowStale = false;
+			lastDrawn = timer::now();
+
+			glClear(GL_COLOR_BUFFER_BIT);
+
+			// Render pixels (Mandlebrot). The frame is rounded up to whole pixels, so it can reach a little past the window
+			double right = texture.width / texture.scale, bottom = texture.height / texture.scale;
+			glEnable(GL_TEXTURE_2D);
+			glBegin(GL_QUADS);
+			glTexCoord2f(0, 0); glVertex2d(0, 0);
+			glTexCoord2f(1, 0); glVertex2d(right, 0);
+			glTexCoord2f(1, 1); glVertex2d(right, bottom);
+			glTexCoord2f(0, 1); glVertex2d(0, bottom);
+			glEnd();
+			glDisable(GL_TEXTURE_2D);
+
+			// Render the cost of each tile over it
+			if (tileHeatmap && backend == BACKEND_CPU && displayedEpoch != 0) drawTileHeatmap(displayedEpoch, displayedView, texture.scale);
+
+			// Render the cursor box
+			glEnableClientState(GL_VERTEX_ARRAY);
+			glEnableClientState(GL_COLOR_ARRAY);
+			glVertexPointer(2, GL_DOUBLE, 0, cursorBox);
+			glColorPointer(3, GL_FLOAT, 0, colour);
+			glDrawArrays(GL_LINE_LOOP, 0, 4);
+			glDisableClientState(GL_COLOR_ARRAY);
+			glDisableClientState(GL_VERTEX_ARRAY);
+
+			glfwSwapBuffers(window);
+			glfwPollEvents();
+		}
+	}
+	catch (const exception& e) { cout << "ERROR (GLFW rendering loop)\n" << e.what() << endl; }
+
+	windowClosed = true;
+	signalRecalculation();
+	finishGpuFrame();
+
+	destroyGpuBackend(gpu);
+	glDeleteTextures(1, &texture.id);
+	glfwTerminate();
+}
+
+/*** ~ IMAGE OUTPUT ~ ***/
+
+/* Writes the lowest '_bytes' bytes of '_value' to '_file', least significant first */
+void writeLittleEndian(std::ofstream& _file, uint32_t _value, int _bytes)
+{
+	for (int i = 0; i < _bytes; i++) _file.put((char)((_value >> (8 * i)) & 0xFF));
+}
+
+/* Writes '_value' to '_file' as 4 bytes, most significant first */
+void writeBigEndian(std::ofstream& _file, uint32_t _value)
+{
+	for (int i = 3; i >= 0; i--) _file.put((char)((_value >> (8 * i)) & 0xFF));
+}
+
+/* Continues the CRC-32 '_crc' (start with 0) over '_size' bytes, as used by the chunks of a PNG file */
+uint32_t updateCrc32(uint32_t _crc, const uint8_t* _data, size_t _size)
+{
+	static const vector<uint32_t> table = []
+	{
+		vector<uint32_t> entries(256);
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			entries[i] = c;
+		}
+		return entries;
+	}();
+	_crc = ~_crc;
+	for (size_t i = 0; i < _size; i++) _crc = table[(_crc ^ _data[i]) & 0xFF] ^ (_crc >> 8);
+	return ~_crc;
+}
+
+/* Continues the Adler-32 '_adler' (start with 1) over '_size' bytes, as used at the end of a zlib stream */
+uint32_t updateAdler32(uint32_t _adler, const uint8_t* _data, size_t _size)
+{
+	uint32_t a = _adler & 0xFFFF, b = _adler >> 16;
+	while (_size > 0)
+	{
+		// 5552 bytes is the most that can be summed before 'b' could overflow
+		size_t count = std::min<size_t>(_size, 5552);
+		for (size_t i = 0; i < count; i++)
+		{
+			a += _data[i];
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+		_data += count;
+		_size -= count;
+	}
+	return (b << 16) | a;
+}
+
+/* Writes one chunk of a PNG file, with its length and CRC */
+void writePngChunk(std::ofstream& _file, const char* _type, const vector<uint8_t>& _data)
+{
+	writeBigEndian(_file, (uint32_t)_data.size());
+	_file.write(_type, 4);
+	if (!_data.empty()) _file.write((const char*)_data.data(), _data.size());
+	uint32_t crc = updateCrc32(0, (const uint8_t*)_type, 4);
+	writeBigEndian(_file, updateCrc32(crc, _data.data(), _data.size()));
+}
+
+/* Writes the header of a PNG file: 8 bit RGB, not interlaced */
+void writePngHeader(MclImageWriter& _image)
+{
+	const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	_image.file.write((const char*)signature, sizeof(signature));
+	vector<uint8_t> header(13, 0);
+	for (int i = 0; i < 4; i++)
+	{
+		header[i] = (uint8_t)(_image.width >> (24 - 8 * i));
+		header[4 + i] = (uint8_t)(_image.height >> (24 - 8 * i));
+	}
+	header[8] = 8; // bits per channel
+	header[9] = 2; // colour type RGB
+	writePngChunk(_image.file, "IHDR", header);
+}
+
+/* Writes the header of an uncompressed 8 bit RGB TIFF file, little endian, with strips of TIFF_STRIP_ROWS rows.
+The rows follow the header in order, so the offset of every strip is known before any of them is written */
+void writeTiffHeader(MclImageWriter& _image)
+{
+	const int entryCount = 13;
+	uint32_t rowBytes = 3 * (uint32_t)_image.width;
+	uint32_t stripCount = (_image.height + TIFF_STRIP_ROWS - 1) / TIFF_STRIP_ROWS;
+
+	// after the directory: bits per sample, the two resolutions, the strip offsets and the strip sizes
+	uint32_t bitsOffset = 8 + 2 + 12 * entryCount + 4;
+	uint32_t resolutionOffset = bitsOffset + 6;
+	uint32_t stripOffsetsOffset = resolutionOffset + 16;
+	uint32_t stripSizesOffset = stripOffsetsOffset + 4 * stripCount;
+	uint32_t dataOffset = stripSizesOffset + 4 * stripCount;
+
+	std::ofstream& file = _image.file;
+	file.write("II", 2);
+	writeLittleEndian(file, 42, 2);
+	writeLittleEndian(file, 8, 4);
+
+	// each entry is a tag, a type (3 = 16 bit, 4 = 32 bit, 5 = rational), a count, and the value or where it is
+	auto entry = [&file](uint32_t _tag, uint32_t _type, uint32_t _count, uint32_t _value)
+	{
+		writeLittleEndian(file, _tag, 2);
+		writeLittleEndian(file, _type, 2);
+		writeLittleEndian(file, _count, 4);
+		writeLittleEndian(file, _value, 4);
+	};
+	writeLittleEndian(file, entryCount, 2);
+	entry(256, 4, 1, _image.width); // width
+	entry(257, 4, 1, _image.height); // height
+	entry(258, 3, 3, bitsOffset); // bits per sample
+	entry(259, 3, 1, 1); // no compression
+	entry(262, 3, 1, 2); // RGB
+	entry(273, 4, stripCount, stripCount == 1 ? dataOffset : stripOffsetsOffset); // strip offsets
+	entry(277, 3, 1, 3); // samples per pixel
+	entry(278, 4, 1, TIFF_STRIP_ROWS); // rows per strip
+	entry(279, 4, stripCount, stripCount == 1 ? rowBytes * _image.height : stripSizesOffset); // strip sizes
+	entry(282, 5, 1, resolutionOffset); // x resolution
+	entry(283, 5, 1, resolutionOffset + 8); // y resolution
+	entry(284, 3, 1, 1); // channels interleaved
+	entry(296, 3, 1, 2); // resolution in inches
+	writeLittleEndian(file, 0, 4); // no further directories
+
+	for (int i = 0; i < 3; i++) writeLittleEndian(file, 8, 2);
+	for (int i = 0; i < 2; i++)
+	{
+		writeLittleEndian(file, 72, 4);
+		writeLittleEndian(file, 1, 4);
+	}
+	for (uint32_t i = 0; i < stripCount; i++) writeLittleEndian(file, dataOffset + i * TIFF_STRIP_ROWS * rowBytes, 4);
+	for (uint32_t i = 0; i < stripCount; i++) writeLittleEndian(file, std::min<uint32_t>(TIFF_STRIP_ROWS, _image.height - i * TIFF_STRIP_ROWS) * rowBytes, 4);
+}
+
+/* Creates the image file '_path' for an image of '_width' x '_height' pixels and writes its header.
+The format is picked from the extension, .png or .tif / .tiff. Returns false if the file cannot be written */
+bool openImage(MclImageWriter& _image, const std::string& _path, int _width, int _height)
+{
+	try
+	{
+		std::string extension = _path.substr(std::min(_path.size(), _path.find_last_of('.')));
+		for (char& c : extension) c = (char)tolower((unsigned char)c);
+		if (extension == ".png") _image.format = IMAGE_PNG;
+		else if (extension == ".tif" || extension == ".tiff") _image.format = IMAGE_TIFF;
+		else
+		{
+			cout << "Unknown image format '" << extension << "', use .png, .tif or .tiff." << endl;
+			return false;
+		}
+
+		// classic TIFF files use 32 bit offsets
+		if (_image.format == IMAGE_TIFF && 3ull * _width * _height + 65536 + 8ull * _height > 0xFFFFFFFFull)
+		{
+			cout << "The image is too large for a TIFF file, use .png instead." << endl;
+			return false;
+		}
+
+		_image.file.open(_path, std::ios::binary | std::ios::trunc);
+		if (!_image.file)
+		{
+			cout << "Cannot create '" << _path << "'." << endl;
+			return false;
+		}
+		_image.width = _width;
+		_image.height = _height;
+		_image.rowsWritten = 0;
+		_image.adler = 1;
+		if (_image.format == IMAGE_PNG) writePngHeader(_image);
+		else writeTiffHeader(_image);
+		return (bool)_image.file;
+	}
+	catch (const exception& e) { cout << "ERROR (openImage)\n" << e.what() << endl; }
+	return false;
+}
+
+/* Appends the next '_rows' rows of the image, given as tightly packed RGB bytes. For a PNG file they go into
+their own IDAT chunk, which continues the zlib stream of the last one in stored (uncompressed) deflate blocks */
+bool writeImageRows(MclImageWriter& _image, const uint8_t* _rgb, int _rows)
+{
+	try
+	{
+		size_t rowBytes = 3 * (size_t)_image.width;
+		if (_image.format == IMAGE_TIFF) _image.file.write((const char*)_rgb, rowBytes * _rows);
+		else
+		{
+			// each row starts with filter type 0, none
+			vector<uint8_t> filtered((rowBytes + 1) * _rows);
+			for (int y = 0; y < _rows; y++)
+			{
+				filtered[y * (rowBytes + 1)] = 0;
+				memcpy(&filtered[y * (rowBytes + 1) + 1], _rgb + y * rowBytes, rowBytes);
+			}
+			_image.adler = updateAdler32(_image.adler, filtered.data(), filtered.size());
+
+			bool last = _image.rowsWritten + _rows == _image.height;
+			vector<uint8_t> chunk;
+			chunk.reserve(filtered.size() + 5 * (filtered.size() / 65535 + 1) + 6);
+			if (_image.rowsWritten == 0)
+			{
+				chunk.push_back(0x78); // deflate with a 32K window
+				chunk.push_back(0x01); // no preset dictionary, lowest compression level
+			}
+			for (size_t offset = 0; offset < filtered.size(); offset += 65535)
+			{
+				uint16_t length = (uint16_t)std::min<size_t>(65535, filtered.size() - offset);
+				chunk.push_back(last && offset + length == filtered.size() ? 1 : 0); // stored block, final at the end of the image
+				chunk.push_back((uint8_t)length);
+				chunk.push_back((uint8_t)(length >> 8));
+				chunk.push_back((uint8_t)~length);
+				chunk.push_back((uint8_t)(~length >> 8));
+				chunk.insert(chunk.end(), filtered.begin() + offset, filtered.begin() + offset + length);
+			}
+			if (last) for (int i = 3; i >= 0; i--) chunk.push_back((uint8_t)(_image.adler >> (8 * i)));
+			writePngChunk(_image.file, "IDAT", chunk);
+		}
+		_image.rowsWritten += _rows;
+		return (bool)_image.file;
+	}
+	catch (const exception& e) { cout << "ERROR (writeImageRows)\n" << e.what() << endl; }
+	return false;
+}
+
+/* Finishes the image file. Returns false if not every row was written, or the file could not be written */
+bool closeImage(MclImageWriter& _image)
+{
+	try
+	{
+		if (_image.format == IMAGE_PNG) writePngChunk(_image.file, "IEND", vector<uint8_t>());
+		_image.file.close();
+		return _image.rowsWritten == _image.height && !_image.file.fail();
+	}
+	catch (const exception& e) { cout << "ERROR (closeImage)\n" << e.what() << endl; }
+	return false;
+}
+
+/* Checks if '_path' is an iteration map, by its extension .mcm */
+bool isIterationMapPath(const std::string& _path)
+{
+	std::string extension = _path.substr(std::min(_path.size(), _path.find_last_of('.')));
+	for (char& c : extension) c = (char)tolower((unsigned char)c);
+	return extension == ".mcm";
+}
+
+/* Creates the iteration map file '_path' for a batch render of '_view' with a kernel of '_precision'. The header is
+written again with the offset of the index once the map is finished, see 'finishIterationMap' */
+bool createIterationMap(MclMapWriter& _map, const std::string& _path, const MclView& _view, MclPrecision _precision)
+{
+	try
+	{
+		_map.file.open(_path, std::ios::binary | std::ios::trunc);
+		if (!_map.file)
+		{
+			cout << "Cannot create '" << _path << "'." << endl;
+			return false;
+		}
+		_map.header = MclMapHeader();
+		memcpy(_map.header.magic, MAP_MAGIC, sizeof(MAP_MAGIC));
+		_map.header.layout[0] = TILE_SIZE;
+		_map.header.layout[1] = BIGFIXED_LIMBS;
+		_map.header.width = _view.width;
+		_map.header.height = _view.height;
+		_map.header.maxIterations = _view.maxIterations;
+		_map.header.precision = _precision;
+		_map.header.interiorChecks = _view.interiorChecks;
+		_map.header.formula = _view.fractal.formula;
+		_map.header.power = _view.fractal.power;
+		_map.header.juliaR = _view.fractal.juliaR;
+		_map.header.juliaI = _view.fractal.juliaI;
+		_map.header.pixelWidth = _view.pixelWidth;
+		_map.header.pixelHeight = _view.pixelHeight;
+		_map.header.exactLeft = _view.exactLeft;
+		_map.header.exactTop = _view.exactTop;
+		_map.file.write((const char*)&_map.header, sizeof(_map.header));
+		_map.size = sizeof(_map.header);
+		_map.index.clear();
+		_map.index.reserve((size_t)getTileCount(_view) + 1);
+		_map.rowsWritten = 0;
+		return (bool)_map.file;
+	}
+	catch (const exception& e) { cout << "ERROR (createIterationMap)\n" << e.what() << endl; }
+	return false;
+}
+
+/* Appends the tiles of the next rows of the map, all the rows of '_iterations' and '_fractions'. Every call but
+the last must add a multiple of TILE_SIZE rows, so the tiles line up with the ones before */
+bool writeIterationMapRows(MclMapWriter& _map, const MclIterationBuffer& _iterations, const MclBuffer<float>& _fractions)
+{
+	try
+	{
+		MclView rows;
+		rows.width = _iterations.width;
+		rows.height = _iterations.height;
+		vector<uint8_t> bytes;
+		for (int tileId = 0; tileId < getTileCount(rows); tileId++)
+		{
+			int startX, endX, startY, endY;
+			getTileBounds(rows, tileId, startX, endX, startY, endY);
+			_map.index.push_back(_map.size + bytes.size());
+			encodeTile(_iterations, _fractions, startX, endX, startY, endY, bytes);
+		}
+		_map.file.write((const char*)bytes.data(), bytes.size());
+		_map.size += bytes.size();
+		_map.rowsWritten += rows.height;
+		return (bool)_map.file;
+	}
+	catch (const exception& e) { cout << "ERROR (writeIterationMapRows)\n" << e.what() << endl; }
+	return false;
+}
+
+/* Writes the index after the tiles, aligned so it can be read in place, and the header again with its offset.
+Returns false if the map is not complete */
+bool finishIterationMap(MclMapWriter& _map)
+{
+	try
+	{
+		_map.index.push_back(_map.size);
+		while (_map.size % sizeof(uint64_t) != 0)
+		{
+			_map.file.put(0);
+			_map.size++;
+		}
+		_map.header.indexOffset = _map.size;
+		_map.file.write((const char*)_map.index.data(), sizeof(uint64_t) * _map.index.size());
+		_map.file.seekp(0);
+		_map.file.write((const char*)&_map.header, sizeof(_map.header));
+		_map.file.close();
+		return _map.rowsWritten == _map.header.height && !_map.file.fail();
+	}
+	catch (const exception& e) { cout << "ERROR (finishIterationMap)\n" << e.what() << endl; }
+	return false;
+}
+
+/* Creates the stream '_path' for an animation of '_width' x '_height' pixel frames at '_fps' frames per second.
+A path with a % is a printf pattern for an image sequence, otherwise the extension picks the format:
+.y4m for YUV4MPEG2, .rgb or .raw for raw RGB frames. Returns false if the stream cannot be written */
+bool openVideo(MclVideoWriter& _video, const std::string& _path, int _width, int _height, int _fps)
+{
+	try
+	{
+		_video.path = _path;
+		_video.width = _width;
+		_video.height = _height;
+		_video.framesWritten = 0;
+		if (_path.find('%') != std::string::npos)
+		{
+			_video.format = VIDEO_IMAGES;
+			return true;
+		}
+		std::string extension = _path.substr(std::min(_path.size(), _path.find_last_of('.')));
+		for (char& c : extension) c = (char)tolower((unsigned char)c);
+		if (extension == ".y4m") _video.format = VIDEO_Y4M;
+		else if (extension == ".rgb" || extension == ".raw") _video.format = VIDEO_RAW;
+		else
+		{
+			cout << "Unknown video format '" << extension << "', use .y4m, .rgb, or an image pattern such as frame%05d.png." << endl;
+			return false;
+		}
+
+		_video.file.open(_path, std::ios::binary | std::ios::trunc);
+		if (!_video.file)
+		{
+			cout << "Cannot create '" << _path << "'." << endl;
+			return false;
+		}
+		if (_video.format == VIDEO_Y4M) _video.file << "YUV4MPEG2 W" << _width << " H" << _height << " F" << _fps << ":1 Ip A1:1 C444\n";
+		return (bool)_video.file;
+	}
+	catch (const exception& e) { cout << "ERROR (openVideo)\n" << e.what() << endl; }
+	return false;
+}
+
+/* Appends the next frame of the animation, given as tightly packed RGB bytes. Y4M frames
+are converted to limited range BT.601 YCbCr, which is what players assume without further tags */
+bool writeVideoFrame(MclVideoWriter& _video, const uint8_t* _rgb)
+{
+	try
+	{
+		size_t pixelCount = (size_t)_video.width * _video.height;
+		if (_video.format == VIDEO_IMAGES)
+		{
+			vector<char> name(_video.path.size() + 32);
+			snprintf(name.data(), name.size(), _video.path.c_str(), _video.framesWritten);
+			MclImageWriter image;
+			if (!openImage(image, name.data(), _video.width, _video.height) || !writeImageRows(image, _rgb, _video.height) || !closeImage(image)) return false;
+		}
+		else if (_video.format == VIDEO_RAW) _video.file.write((const char*)_rgb, 3 * pixelCount);
+		else
+		{
+			vector<uint8_t> planes(3 * pixelCount);
+			for (size_t i = 0; i < pixelCount; i++)
+			{
+				int r = _rgb[3 * i], g = _rgb[3 * i + 1], b = _rgb[3 * i + 2];
+				planes[i] = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+				planes[pixelCount + i] = (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+				planes[2 * pixelCount + i] = (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+			}
+			_video.file << "FRAME\n";
+			_video.file.write((const char*)planes.data(), planes.size());
+		}
+		_video.framesWritten++;
+		return _video.format == VIDEO_IMAGES || (bool)_video.file;
+	}
+	catch (const exception& e) { cout << "ERROR (writeVideoFrame)\n" << e.what() << endl; }
+	return false;
+}
+
+/* Finishes the animation stream. Returns false if it could not be written */
+bool closeVideo(MclVideoWriter& _video)
+{
+	if (_video.format == VIDEO_IMAGES) return true;
+	_video.file.close();
+	return !_video.file.fail();
+}
+
+/*** ~ DISTRIBUTED RENDERING ~ ***/
+
+// first bytes of the greeting of both ends of a render farm connection
+const char FARM_MAGIC[8] = "MCLFARM";
+
+/* Appends the tiles of '_range' of the back buffer, a frame of '_view', to '_bytes', compressed with 'encodeTile' */
+void encodeTiles(const MclView& _view, const MclTileRange& _range, vector<uint8_t>& _bytes)
+{
+	for (int tileId = _range.first; tileId < _range.first + _range.count; tileId++)
+	{
+		int startX, endX, startY, endY;
+		getTileBounds(_view, tileId, startX, endX, startY, endY);
+		encodeTile(pixels, fractionPixels, startX, endX, startY, endY, _bytes);
+	}
+}
+
+/* Reads the tiles of '_range' written by 'encodeTiles' at '_offset' of '_bytes' into the back buffer, a frame of '_view'.
+Returns false if the bytes do not hold exactly those tiles */
+bool decodeTiles(const MclView& _view, const MclTileRange& _range, const vector<uint8_t>& _bytes, size_t _offset)
+{
+	const uint8_t* data = _bytes.data() + _offset;
+	const uint8_t* end = _bytes.data() + _bytes.size();
+	vector<uint32_t> iterations(TILE_SIZE * TILE_SIZE);
+	vector<float> fractions(TILE_SIZE * TILE_SIZE);
+	for (int tileId = _range.first; tileId < _range.first + _range.count; tileId++)
+	{
+		int startX, endX, startY, endY;
+		getTileBounds(_view, tileId, startX, endX, startY, endY);
+		int width = endX - startX;
+		if (!decodeTile(data, end, width * (endY - startY), iterations.data(), fractions.data())) return false;
+		for (int y = startY; y < endY; y++)
+		{
+			memcpy(pixels.row(y) + startX, &iterations[(y - startY) * width], sizeof(uint32_t) * width);
+			memcpy(fractionPixels.row(y) + startX, &fractions[(y - startY) * width], sizeof(float) * width);
+		}
+	}
+	return data == end;
+}
+
+/* Writes the greeting of one end of a render farm connection with '_threads' worker threads to '_message' */
+void encodeHello(int _threads, vector<uint8_t>& _message)
+{
+	_message.clear();
+	putVarint(_message, FARM_HELLO);
+	putBytes(_message, FARM_MAGIC, sizeof(FARM_MAGIC));
+	putVarint(_message, FARM_PROTOCOL_VERSION);
+	putVarint(_message, BIGFIXED_LIMBS);
+	putVarint(_message, _threads);
+}
+
+/* Reads the greeting of the other end of a render farm connection, and gets its number of worker threads. Returns false
+if it is not a greeting of the same version of the protocol and build */
+bool decodeHello(const vector<uint8_t>& _message, int& _threads)
+{
+	size_t offset = 0;
+	int type, version, limbs;
+	char magic[sizeof(FARM_MAGIC)];
+	return getVarint(_message, offset, type, FARM_HELLO, FARM_HELLO) && getBytes(_message, offset, magic, sizeof(magic)) && memcmp(magic, FARM_MAGIC, sizeof(magic)) == 0
+		&& getVarint(_message, offset, version, FARM_PROTOCOL_VERSION, FARM_PROTOCOL_VERSION) && getVarint(_message, offset, limbs, BIGFIXED_LIMBS, BIGFIXED_LIMBS)
+		&& getVarint(_message, offset, _threads, 1, INT_MAX) && offset == _message.size();
+}
+
+/* Writes the job of computing the tiles of '_range' of a frame of '_view' with a kernel of '_precision' to '_message'.
+The node picks its own fastest kernel of that precision, which counts the same iterations as the one of the coordinator */
+void encodeJob(const MclView& _view, MclPrecision _precision, const MclTileRange& _range, vector<uint8_t>& _message)
+{
+	_message.clear();
+	putVarint(_message, FARM_JOB);
+	putVarint(_message, _range.epoch);
+	putVarint(_message, _range.first);
+	putVarint(_message, _range.count);
+	putVarint(_message, _view.width);
+	putVarint(_message, _view.height);
+	putVarint(_message, _view.maxIterations);
+	putVarint(_message, _view.interiorChecks);
+	putVarint(_message, _precision);
+	putVarint(_message, _view.fractal.formula);
+	putVarint(_message, _view.fractal.power);
+	putBytes(_message, &_view.fractal.juliaR, sizeof(double));
+	putBytes(_message, &_view.fractal.juliaI, sizeof(double));
+	putBytes(_message, &_view.pixelWidth, sizeof(double));
+	putBytes(_message, &_view.pixelHeight, sizeof(double));
+	putBytes(_message, _view.exactLeft.limb, sizeof(_view.exactLeft.limb));
+	putBytes(_message, _view.exactTop.limb, sizeof(_view.exactTop.limb));
+}
+
+/* Reads a job written by 'encodeJob'. Returns false if it is malformed, or its tiles are not in its view */
+bool decodeJob(const vector<uint8_t>& _message, MclView& _view, MclPrecision& _precision, MclTileRange& _range)
+{
+	size_t offset = 0;
+	int type, epoch, interiorChecks, precision;
+	bool valid = getVarint(_message, offset, type, FARM_JOB, FARM_JOB) && getVarint(_message, offset, epoch, 0, INT_MAX)
+		&& getVarint(_message, offset, _range.first, 0, INT_MAX) && getVarint(_message, offset, _range.count, 1, FARM_MAX_JOB_TILES)
+		&& getVarint(_message, offset, _view.width, 1, 1 << 20) && getVarint(_message, offset, _view.height, 1, 1 << 20)
+		&& getVarint(_message, offset, _view.maxIterations, MIN_MAX_ITERATIONS, MAX_MAX_ITERATIONS) && getVarint(_message, offset, interiorChecks, 0, 1)
+		&& getVarint(_message, offset, precision, PRECISION_FLOAT, PRECISION_PERTURBATION)
+		&& getVarint(_message, offset, _view.fractal.formula, 0, FORMULA_COUNT - 1) && getVarint(_message, offset, _view.fractal.power, 2, MAX_POWER)
+		&& getBytes(_message, offset, &_view.fractal.juliaR, sizeof(double)) && getBytes(_message, offset, &_view.fractal.juliaI, sizeof(double))
+		&& getBytes(_message, offset, &_view.pixelWidth, sizeof(double)) && getBytes(_message, offset, &_view.pixelHeight, sizeof(double))
+		&& getBytes(_message, offset, _view.exactLeft.limb, sizeof(_view.exactLeft.limb)) && getBytes(_message, offset, _view.exactTop.limb, sizeof(_view.exactTop.limb))
+		&& offset == _message.size() && (int64_t)_view.width * _view.height <= 1 << 28 && _range.first + _range.count <= getTileCount(_view);
+	if (!valid) return false;
+	_range.epoch = (uint32_t)epoch;
+	_view.interiorChecks = interiorChecks != 0;
+	_view.left = toDoubleDouble(_view.exactLeft);
+	_view.top = toDoubleDouble(_view.exactTop);
+	_view.generation = viewGeneration;
+	_precision = (MclPrecision)precision;
+	return true;
+}
+
+/* Sends '_size' bytes at '_data' over '_socket'. Returns false if the connection failed */
+bool sendAll(SOCKET _socket, const void* _data, size_t _size)
+{
+	const char* data = (const char*)_data;
+	while (_size > 0)
+	{
+		int sent = send(_socket, data, (int)std::min<size_t>(_size, INT_MAX), 0);
+		if (sent <= 0) return false;
+		data += sent;
+		_size -= sent;
+	}
+	return true;
+}
+
+/* Receives '_size' bytes from '_socket' into '_data'. Returns false if the connection failed, was closed or timed out */
+bool receiveAll(SOCKET _socket, void* _data, size_t _size)
+{
+	char* data = (char*)_data;
+	while (_size > 0)
+	{
+		int received = recv(_socket, data, (int)std::min<size_t>(_size, INT_MAX), 0);
+		if (received <= 0) return false;
+		data += received;
+		_size -= received;
+	}
+	return true;
+}
+
+/* Sends a message over '_socket', its size in front of it */
+bool sendMessage(SOCKET _socket, const vector<uint8_t>& _message)
+{
+	uint32_t size = (uint32_t)_message.size();
+	vector<uint8_t> framed;
+	framed.reserve(sizeof(size) + _message.size());
+	putBytes(framed, &size, sizeof(size));
+	putBytes(framed, _message.data(), _message.size());
+	return sendAll(_socket, framed.data(), framed.size());
+}
+
+/* Receives a message sent by 'sendMessage' from '_socket'. Returns false if the connection failed or it is larger than FARM_MAX_MESSAGE */
+bool receiveMessage(SOCKET _socket, vector<uint8_t>& _message)
+{
+	uint32_t size = 0;
+	if (!receiveAll(_socket, &size, sizeof(size)) || size > FARM_MAX_MESSAGE) return false;
+	_message.resize(size);
+	return receiveAll(_socket, _message.data(), size);
+}
+
+/* Computes the job in '_message' on the worker pool and writes its tiles to '_reply'. Tiles in the tile cache are not
+computed again and the computed ones are added to it, so a job sent again after a lost connection costs little.
+'_references' keeps the reference orbits of the last perturbation frame, as most jobs in a row are of the same one.
+Returns false if the job is malformed */
+bool computeFarmJob(const vector<uint8_t>& _message, vector<uint8_t>& _reply, MclView& _references)
+{
+	MclView view;
+	MclPrecision precision;
+	MclTileRange range;
+	if (!decodeJob(_message, view, precision, range)) return false;
+	int kernelIndex = findKernel(precision);
+	if (kernelArray[kernelIndex].precision == PRECISION_PERTURBATION)
+	{
+		bool sameFrame = _references.references && _references.width == view.width && _references.height == view.height
+			&& isSameTile(getTileKey(_references, kernelIndex, 0), getTileKey(view, kernelIndex, 0));
+		if (!sameFrame)
+		{
+			_references = view;
+			_references.references = createReferenceSet(view);
+		}
+		view.references = _references.references;
+	}
+
+	uint32_t epoch = startFrame(view);
+	vector<bool> needed(getTileCount(view), false);
+	for (int tileId = range.first; tileId < range.first + range.count; tileId++) needed[tileId] = true;
+	fetchCachedTiles(view, kernelIndex, epoch, needed);
+	submitTiles(kernelArray[kernelIndex].function, view, epoch, getThreadCount(), needed, 1, false, false, 0);
+	waitForJobs();
+	storeFinishedTiles(view, kernelIndex, epoch, needed);
+
+	_reply.clear();
+	putVarint(_reply, FARM_TILES);
+	putVarint(_reply, range.epoch);
+	putVarint(_reply, range.first);
+	putVarint(_reply, range.count);
+	encodeTiles(view, range, _reply);
+	return true;
+}
+
+/* Serves the coordinator of a render farm on '_connection' until it disconnects: greets it, then computes its jobs one
+after the other. The coordinator keeps the next job waiting in the connection meanwhile */
+void serveCoordinator(SOCKET _connection, const std::string& _peer)
+{
+	int noDelay = 1;
+	setsockopt(_connection, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+	vector<uint8_t> message, reply;
+	int coordinatorThreads = 0;
+	if (!receiveMessage(_connection, message) || !decodeHello(message, coordinatorThreads))
+	{
+		cout << "Dropped " << _peer << ", it is not a coordinator of this build." << endl;
+		return;
+	}
+	encodeHello(getThreadCount(), reply);
+	if (!sendMessage(_connection, reply)) return;
+	cout << "Coordinator " << _peer << " connected." << endl;
+
+	int jobs = 0;
+	MclView references;
+	timer::time_point start = timer::now();
+	while (receiveMessage(_connection, message) && computeFarmJob(message, reply, references) && sendMessage(_connection, reply)) jobs++;
+	cout << "Coordinator " << _peer << " left after " << jobs << " jobs (" << duration_cast<milliseconds>(timer::now() - start).count() << "ms)." << endl;
+}
+
+/* Runs this process as a worker of a render farm. Listens on '_port' over IPv6 and IPv4, and serves one coordinator
+at a time until it disconnects. Only returns if it cannot listen */
+bool runFarmWorker(int _port)
+{
+	WSADATA winsock;
+	if (WSAStartup(MAKEWORD(2, 2), &winsock) != 0)
+	{
+		cout << "Cannot start Winsock." << endl;
+		return false;
+	}
+	SOCKET listener = socket(AF_INET6, SOCK_STREAM, IPPROTO_TCP);
+	if (listener != INVALID_SOCKET)
+	{
+		int v6Only = 0;
+		setsockopt(listener, IPPROTO_IPV6, IPV6_V6ONLY, (const char*)&v6Only, sizeof(v6Only));
+		sockaddr_in6 address = {};
+		address.sin6_family = AF_INET6;
+		address.sin6_addr = in6addr_any;
+		address.sin6_port = htons((unsigned short)_port);
+		if (bind(listener, (const sockaddr*)&address, sizeof(address)) == SOCKET_ERROR || listen(listener, SOMAXCONN) == SOCKET_ERROR)
+		{
+			closesocket(listener);
+			listener = INVALID_SOCKET;
+		}
+	}
+	if (listener == INVALID_SOCKET)
+	{
+		cout << "Cannot listen on port " << _port << "." << endl;
+		WSACleanup();
+		return false;
+	}
+
+	// tiles asked for again are served from the cache, by other coordinators and later runs too
+	openTileStore();
+	cout << "Worker of a render farm on port " << _port << " with " << getThreadCount() << " threads [" << kernelArray[findKernel(PRECISION_FLOAT)].name << "]" << endl;
+	for (;;)
+	{
+		sockaddr_storage peer = {};
+		socklen_t peerSize = sizeof(peer);
+		SOCKET connection = accept(listener, (sockaddr*)&peer, &peerSize);
+		if (connection == INVALID_SOCKET) break;
+		char host[NI_MAXHOST] = "?";
+		getnameinfo((const sockaddr*)&peer, peerSize, host, sizeof(host), NULL, 0, NI_NUMERICHOST);
+		serveCoordinator(connection, host);
+		closesocket(connection);
+	}
+	closesocket(listener);
+	closeTileStore();
+	WSACleanup();
+	return false;
+}
+
+/* Connects to the worker process '_node' and greets it, trying every address of its host name for FARM_CONNECT_TIMEOUT
+at most. Returns INVALID_SOCKET if it cannot be reached or is not a worker of this build */
+SOCKET connectToNode(MclFarmNode& _node)
+{
+	addrinfo hints = {};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	addrinfo* addresses = nullptr;
+	if (getaddrinfo(_node.host.c_str(), _node.port.c_str(), &hints, &addresses) != 0) return INVALID_SOCKET;
+	SOCKET connection = INVALID_SOCKET;
+	for (addrinfo* address = addresses; address && connection == INVALID_SOCKET; address = address->ai_next)
+	{
+		connection = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+		if (connection == INVALID_SOCKET) continue;
+
+		// connect without blocking, and wait until the socket is writable or the time is up
+		u_long nonBlocking = 1;
+		ioctlsocket(connection, FIONBIO, &nonBlocking);
+		bool connected = connect(connection, address->ai_addr, (int)address->ai_addrlen) == 0;
+		if (!connected && WSAGetLastError() == WSAEWOULDBLOCK)
+		{
+			fd_set writable, failed;
+			FD_ZERO(&writable);
+			FD_ZERO(&failed);
+			FD_SET(connection, &writable);
+			FD_SET(connection, &failed);
+			timeval timeout = { FARM_CONNECT_TIMEOUT / 1000, FARM_CONNECT_TIMEOUT % 1000 * 1000 };
+			int error = 0;
+			socklen_t errorSize = sizeof(error);
+			connected = select((int)connection + 1, NULL, &writable, &failed, &timeout) > 0 && FD_ISSET(connection, &writable)
+				&& getsockopt(connection, SOL_SOCKET, SO_ERROR, (char*)&error, &errorSize) == 0 && error == 0;
+		}
+		nonBlocking = 0;
+		ioctlsocket(connection, FIONBIO, &nonBlocking);
+		if (!connected)
+		{
+			closesocket(connection);
+			connection = INVALID_SOCKET;
+		}
+	}
+	freeaddrinfo(addresses);
+	if (connection == INVALID_SOCKET) return INVALID_SOCKET;
+
+	int noDelay = 1;
+	DWORD timeout = FARM_RECEIVE_TIMEOUT;
+	setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+	setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+	vector<uint8_t> hello;
+	encodeHello(getThreadCount(), hello);
+	if (!sendMessage(connection, hello) || !receiveMessage(connection, hello) || !decodeHello(hello, _node.threads))
+	{
+		closesocket(connection);
+		return INVALID_SOCKET;
+	}
+	return connection;
+}
+
+/* Takes up to '_count' tiles off the front of the queue of the render farm into '_range'. Returns false if the queue
+is empty. Must be called with 'renderFarm.lock' held */
+bool takeFarmTiles(int _count, MclTileRange& _range)
+{
+	if (renderFarm.queue.empty()) return false;
+	MclTileRange& front = renderFarm.queue.front();
+	_range = front;
+	_range.count = std::min({ _count, front.count, FARM_MAX_JOB_TILES });
+	front.first += _range.count;
+	front.count -= _range.count;
+	if (front.count == 0) renderFarm.queue.pop_front();
+	return true;
+}
+
+/* Counts '_count' more tiles of the frame of the render farm as received, and wakes 'waitForFarmFrame' once they all are.
+Must be called with 'renderFarm.lock' held */
+void finishFarmTiles(int _count)
+{
+	renderFarm.tilesLeft -= _count;
+	if (renderFarm.tilesLeft == 0) renderFarm.changed.notify_all();
+}
+
+/* Reads the tiles of the job '_range' sent back by a node into the back buffer. Returns false if the message is not them */
+bool receiveFarmTiles(const vector<uint8_t>& _message, const MclTileRange& _range)
+{
+	size_t offset = 0;
+	int type, epoch, first, count;
+	if (!getVarint(_message, offset, type, FARM_TILES, FARM_TILES) || !getVarint(_message, offset, epoch, 0, INT_MAX) || !getVarint(_message, offset, first, 0, INT_MAX)
+		|| !getVarint(_message, offset, count, 0, INT_MAX) || (uint32_t)epoch != _range.epoch || first != _range.first || count != _range.count) return false;
+
+	// the frame cannot change before these tiles are counted, so its view is read without the lock
+	if (!decodeTiles(renderFarm.view, _range, _message, offset)) return false;
+	unique_lock<mutex> lk(renderFarm.lock);
+	finishFarmTiles(_range.count);
+	return true;
+}
+
+/* Shares the frames of the render farm with the worker process '_node', until the farm shuts down. It is sent
+FARM_JOBS_IN_FLIGHT jobs of FARM_TILES_PER_THREAD tiles for each of its threads, and another one whenever the tiles
+of one come back. If the connection is lost or the node stops answering, its jobs go back to the front of the queue
+for the other nodes, and it is connected to again FARM_RETRY_DELAY later */
+void runFarmNode(MclFarmNode& _node)
+{
+	std::string name = _node.host + ":" + _node.port;
+	SOCKET connection = INVALID_SOCKET;
+	deque<MclTileRange> sent;
+	vector<uint8_t> message;
+	for (;;)
+	{
+		{
+			unique_lock<mutex> lk(renderFarm.lock);
+			renderFarm.changed.wait(lk, [&] { return renderFarm.shutdown || !renderFarm.queue.empty() || !sent.empty(); });
+			if (renderFarm.shutdown) break;
+		}
+
+		// only connect while there are tiles to compute
+		if (connection == INVALID_SOCKET)
+		{
+			connection = connectToNode(_node);
+			if (connection == INVALID_SOCKET)
+			{
+				unique_lock<mutex> lk(renderFarm.lock);
+				renderFarm.changed.wait_for(lk, milliseconds(FARM_RETRY_DELAY), [] { return renderFarm.shutdown; });
+				continue;
+			}
+			cout << "\rConnected to " << name << " (" << _node.threads << (_node.threads == 1 ? " thread)." : " threads).") << endl;
+		}
+
+		bool failed = false;
+		for (;;)
+		{
+			MclTileRange range;
+			{
+				unique_lock<mutex> lk(renderFarm.lock);
+				if ((int)sent.size() >= FARM_JOBS_IN_FLIGHT || !takeFarmTiles(_node.threads * FARM_TILES_PER_THREAD, range)) break;
+				encodeJob(renderFarm.view, kernelArray[renderFarm.kernelIndex].precision, range, message);
+			}
+			sent.push_back(range);
+			if (!sendMessage(connection, message))
+			{
+				failed = true;
+				break;
+			}
+		}
+		if (!failed && !sent.empty())
+		{
+			failed = !receiveMessage(connection, message) || !receiveFarmTiles(message, sent.front());
+			if (!failed)
+			{
+				_node.tiles += sent.front().count;
+				sent.pop_front();
+			}
+		}
+
+		if (failed)
+		{
+			closesocket(connection);
+			connection = INVALID_SOCKET;
+			_node.drops++;
+			cout << "\rLost the connection to " << name << ", its " << sent.size() << " jobs are handed out again." << endl;
+			unique_lock<mutex> lk(renderFarm.lock);
+			renderFarm.queue.insert(renderFarm.queue.begin(), sent.begin(), sent.end());
+			sent.clear();
+			renderFarm.changed.notify_all();
+		}
+	}
+	if (connection != INVALID_SOCKET) closesocket(connection);
+}
+
+/* Computes the tiles of the render farm on the worker pool of this process, as its last node. Runs until the farm shuts down */
+void runLocalNode()
+{
+	for (;;)
+	{
+		MclTileRange range;
+		MclView view;
+		int kernelIndex;
+		{
+			unique_lock<mutex> lk(renderFarm.lock);
+			renderFarm.changed.wait(lk, [] { return renderFarm.shutdown || !renderFarm.queue.empty(); });
+			if (renderFarm.shutdown) return;
+			takeFarmTiles(getThreadCount() * FARM_TILES_PER_THREAD, range);
+			view = renderFarm.view;
+			kernelIndex = renderFarm.kernelIndex;
+		}
+		vector<bool> needed(getTileCount(view), false);
+		for (int tileId = range.first; tileId < range.first + range.count; tileId++) needed[tileId] = true;
+		submitTiles(kernelArray[kernelIndex].function, view, range.epoch, getThreadCount(), needed, 1, false, false, 0);
+		waitForJobs();
+		unique_lock<mutex> lk(renderFarm.lock);
+		renderFarm.localTiles += range.count;
+		finishFarmTiles(range.count);
+	}
+}
+
+/* Starts a render farm with the worker processes in '_nodes', "host:port" separated by commas (IPv6 addresses in brackets).
+Frames of batch renders are then shared with them, see 'submitBatchFrame'. Returns false if the list is malformed */
+bool startRenderFarm(const std::string& _nodes)
+{
+	if (_nodes.empty()) return true;
+	std::stringstream list(_nodes);
+	std::string entry;
+	while (std::getline(list, entry, ','))
+	{
+		size_t colon = entry.find_last_of(':');
+		if (colon == std::string::npos || colon == 0 || colon + 1 == entry.size())
+		{
+			cout << "Invalid node '" << entry << "', expected <host>:<port>." << endl;
+			renderFarm.nodes.clear();
+			return false;
+		}
+		MclFarmNode node;
+		node.host = entry.substr(0, colon);
+		node.port = entry.substr(colon + 1);
+		if (node.host.size() > 2 && node.host.front() == '[' && node.host.back() == ']') node.host = node.host.substr(1, node.host.size() - 2);
+		renderFarm.nodes.push_back(std::move(node));
+	}
+	WSADATA winsock;
+	if (WSAStartup(MAKEWORD(2, 2), &winsock) != 0)
+	{
+		cout << "Cannot start Winsock." << endl;
+		renderFarm.nodes.clear();
+		return false;
+	}
+	renderFarm.shutdown = false;
+	for (MclFarmNode& node : renderFarm.nodes) node.connection = thread(runFarmNode, std::ref(node));
+	renderFarm.local = thread(runLocalNode);
+	return true;
+}
+
+/* Stops the render farm, and prints how many tiles each node computed */
+void stopRenderFarm()
+{
+	if (renderFarm.nodes.empty()) return;
+	{
+		unique_lock<mutex> lk(renderFarm.lock);
+		renderFarm.shutdown = true;
+		renderFarm.changed.notify_all();
+	}
+	for (MclFarmNode& node : renderFarm.nodes) node.connection.join();
+	renderFarm.local.join();
+	cout << "This process: " << renderFarm.localTiles << " tiles" << endl;
+	for (const MclFarmNode& node : renderFarm.nodes)
+	{
+		cout << node.host << ":" << node.port << ": " << node.tiles << " tiles";
+		if (node.drops > 0) cout << ", " << node.drops << (node.drops == 1 ? " lost connection" : " lost connections");
+		cout << endl;
+	}
+	renderFarm.nodes.clear();
+	WSACleanup();
+}
+
+/* Hands all tiles of frame '_epoch' of '_view', computed with the kernel '_kernelIndex', to the nodes of the render farm */
+void submitFarmFrame(const MclView& _view, int _kernelIndex, uint32_t _epoch)
+{
+	unique_lock<mutex> lk(renderFarm.lock);
+	renderFarm.view = _view;
+	renderFarm.kernelIndex = _kernelIndex;
+	MclTileRange all;
+	all.epoch = _epoch;
+	all.count = getTileCount(_view);
+	renderFarm.queue.assign(1, all);
+	renderFarm.tilesLeft = all.count;
+	renderFarm.changed.notify_all();
+}
+
+/* Blocks until every tile of the frame of the render farm was received */
+void waitForFarmFrame()
+{
+	unique_lock<mutex> lk(renderFarm.lock);
+	renderFarm.changed.wait(lk, [] { return renderFarm.tilesLeft == 0; });
+}
+
+/*** ~ BATCH RENDERING ~ ***/
+
+/* Reads the command line of a batch render into '_options'. Returns false if an option is unknown or invalid */
+bool parseBatchOptions(int _argc, char** _argv, MclBatchOptions& _options)
+{
+	bool sizeGiven = false;
+	for (int i = 1; i < _argc; i++)
+	{
+		std::string option = _argv[i];
+		int remaining = _argc - 1 - i;
+		if (option == "--center" && remaining >= 2)
+		{
+			if (!parseBigFixed(_argv[i + 1], _options.centreX) || !parseBigFixed(_argv[i + 2], _options.centreY)) return false;
+			_options.centreGiven = true;
+			i += 2;
+		}
+		else if (option == "--julia" && remaining >= 2)
+		{
+			_options.fractal.formula = FORMULA_JULIA;
+			_options.fractal.juliaR = atof(_argv[++i]);
+			_options.fractal.juliaI = atof(_argv[++i]);
+		}
+		else if (option == "--burning-ship") _options.fractal.formula = FORMULA_BURNING_SHIP;
+		else if (option == "--power" && remaining >= 1)
+		{
+			_options.fractal.power = atoi(_argv[++i]);
+			if (_options.fractal.power < 2 || _options.fractal.power > MAX_POWER) return false;
+		}
+		else if (option == "--zoom" && remaining >= 1)
+		{
+			_options.zoom = atof(_argv[++i]);
+			if (!(_options.zoom > 0.0)) return false;
+		}
+		else if (option == "--size" && remaining >= 1)
+		{
+			if (sscanf(_argv[++i], "%dx%d", &_options.width, &_options.height) != 2 || _options.width < 1 || _options.height < 1) return false;
+			sizeGiven = true;
+		}
+		else if (option == "--iterations" && remaining >= 1)
+		{
+			_options.maxIterations = atoi(_argv[++i]);
+			if (_options.maxIterations < MIN_MAX_ITERATIONS || _options.maxIterations > MAX_MAX_ITERATIONS) return false;
+		}
+		else if (option == "--threads" && remaining >= 1)
+		{
+			_options.threads = atoi(_argv[++i]);
+			if (_options.threads < 1 || _options.threads > MAX_THREADS) return false;
+		}
+		else if (option == "--keyframes" && remaining >= 1) _options.keyframes = _argv[++i];
+		else if (option == "--frames" && remaining >= 1)
+		{
+			_options.frames = atoi(_argv[++i]);
+			if (_options.frames < 1) return false;
+		}
+		else if (option == "--fps" && remaining >= 1)
+		{
+			_options.fps = atoi(_argv[++i]);
+			if (_options.fps < 1 || _options.fps > 1000) return false;
+		}
+		else if (option == "--palette" && remaining >= 1)
+		{
+			std::string name = _argv[++i];
+			_options.palette = -1;
+			for (int p = 0; p < PALETTE_COUNT; p++) if (name == paletteArray[p].name || name == std::to_string(p)) _options.palette = p;
+			if (_options.palette == -1) return false;
+		}
+		else if (option == "--bands") _options.smooth = false;
+		else if (option == "--pin") _options.pin = true;
+		else if (option == "--output" && remaining >= 1) _options.output = _argv[++i];
+		else if (option == "--bench" && remaining >= 1) _options.bench = _argv[++i];
+		else if (option == "--repeat" && remaining >= 1)
+		{
+			_options.repeats = atoi(_argv[++i]);
+			if (_options.repeats < 1) return false;
+		}
+		else if (option == "--farm" && remaining >= 1) _options.farm = _argv[++i];
+		else if (option == "--serve" && remaining >= 1)
+		{
+			_options.servePort = atoi(_argv[++i]);
+			if (_options.servePort < 1 || _options.servePort > 65535) return false;
+		}
+		else return false;
+	}
+	if (!_options.bench.empty() && !sizeGiven)
+	{
+		_options.width = BENCH_WIDTH;
+		_options.height = BENCH_HEIGHT;
+	}
+	if (_options.repeats == 0) _options.repeats = BENCH_REPEATS;
+	if (!_options.centreGiven && (_options.fractal.formula != FORMULA_MANDELBROT || _options.fractal.power > 2))
+	{
+		_options.centreX = MclBigFixed(_options.fractal.formula == FORMULA_BURNING_SHIP ? -0.5 : 0.0);
+		_options.centreY = MclBigFixed(_options.fractal.formula == FORMULA_BURNING_SHIP ? -0.5 : 0.0);
+	}
+	if (_options.threads == 0) _options.threads = getAutomaticThreadCount();
+	if (_options.output.empty()) _options.output = _options.keyframes.empty() ? "mandelbrot.png" : "mandelbrot.y4m";
+	return true;
+}
+
+/* Reads the keyframes of an animation from '_path'. Each line holds the time in seconds, the centre and the zoom,
+e.g. "2.5 -0.743643887037151 0.131825904205330 1e6". Empty lines and lines starting with # are skipped.
+Returns false if the file cannot be read, a line is invalid or the times do not increase */
+bool loadKeyframes(const std::string& _path, vector<MclKeyframe>& _keyframes)
+{
+	std::ifstream file(_path);
+	if (!file)
+	{
+		cout << "Cannot read '" << _path << "'." << endl;
+		return false;
+	}
+	std::string line;
+	for (int lineNumber = 1; std::getline(file, line); lineNumber++)
+	{
+		std::istringstream fields(line);
+		std::string time, centreX, centreY, zoom, rest;
+		if (!(fields >> time) || time[0] == '#') continue;
+		MclKeyframe keyframe;
+		bool valid = (bool)(fields >> centreX >> centreY >> zoom) && !(fields >> rest);
+		if (valid)
+		{
+			keyframe.time = atof(time.c_str());
+			keyframe.zoom = atof(zoom.c_str());
+			valid = parseBigFixed(centreX.c_str(), keyframe.centreX) && parseBigFixed(centreY.c_str(), keyframe.centreY) && keyframe.zoom > 0.0;
+			valid = valid && (_keyframes.empty() || keyframe.time > _keyframes.back().time);
+		}
+		if (!valid)
+		{
+			cout << "Invalid keyframe on line " << lineNumber << " of '" << _path << "', expected <time> <re> <im> <zoom> with increasing times." << endl;
+			return false;
+		}
+		_keyframes.push_back(keyframe);
+	}
+	if (_keyframes.empty()) cout << "No keyframes in '" << _path << "'." << endl;
+	return !_keyframes.empty();
+}
+
+/* Gets the settings of the animation frame at '_time', between the keyframes around it. The zoom changes
+at a steady rate (linearly in log scale). The centre moves at the rate the zoom closes in on the next centre,
+so the next centre comes into view and stays still on screen rather than being overtaken while zooming in */
+MclBatchOptions getKeyframeOptions(const MclBatchOptions& _options, const vector<MclKeyframe>& _keyframes, double _time)
+{
+	size_t next = std::min<size_t>(1, _keyframes.size() - 1);
+	while (next < _keyframes.size() - 1 && _keyframes[next].time < _time) next++;
+	const MclKeyframe& from = _keyframes[next > 0 ? next - 1 : 0];
+	const MclKeyframe& to = _keyframes[next];
+
+	MclBatchOptions frame = _options;
+	double progress = to.time > from.time ? std::min(std::max((_time - from.time) / (to.time - from.time), 0.0), 1.0) : 0.0;
+	frame.zoom = from.zoom * pow(to.zoom / from.zoom, progress);
+
+	// the share of the way to the new centre, as the part of the width of the view closed so far
+	double weight = progress;
+	if (fabs(log(to.zoom / from.zoom)) > 1e-9) weight = (1.0 - from.zoom / frame.zoom) / (1.0 - from.zoom / to.zoom);
+	frame.centreX = from.centreX + (to.centreX - from.centreX) * MclBigFixed(weight);
+	frame.centreY = from.centreY + (to.centreY - from.centreY) * MclBigFixed(weight);
+	return frame;
+}
+
+/* Gets the view of the whole image of a batch render. Pixels are square, and a zoom of 1
+shows the same width of the plane as the default view of the window (see 'resetZoom') */
+MclView getBatchView(const MclBatchOptions& _options)
+{
+	MclView image;
+	image.width = _options.width;
+	image.height = _options.height;
+	image.pixelWidth = 3.0 / _options.zoom / _options.width;
+	image.pixelHeight = -image.pixelWidth;
+	image.exactLeft = toBigFixed(_options.centreX, -_options.width / 2.0, image.pixelWidth);
+	image.exactTop = toBigFixed(_options.centreY, -_options.height / 2.0, image.pixelHeight);
+	image.left = toDoubleDouble(image.exactLeft);
+	image.top = toDoubleDouble(image.exactTop);
+	image.interiorChecks = true;
+	image.fractal = _options.fractal;
+	image.generation = viewGeneration;
+	if (_options.maxIterations != 0) image.maxIterations = _options.maxIterations;
+	else
+	{
+		adaptiveIterations = true;
+		image.maxIterations = getMaxIterations(image);
+	}
+	return image;
+}
+
+/* Gets the view of the rows '_startY' to '_startY + _rows' of the image of a batch render */
+MclView getStripView(const MclView& _image, int _startY, int _rows)
+{
+	MclView strip = _image;
+	strip.height = _rows;
+	strip.exactTop = toBigFixed(_image.exactTop, _startY, _image.pixelHeight);
+	strip.top = toDoubleDouble(strip.exactTop);
+	return strip;
+}
+
+/* Starts a frame of a batch render for '_view' with the kernel '_kernelIndex' and hands all of its tiles to
+the workers, or to the render farm if there is one, without waiting for them. Perturbation frames get their own reference orbits */
+void submitBatchFrame(MclView _view, int _kernelIndex, int _workerCount)
+{
+	if (kernelArray[_kernelIndex].precision == PRECISION_PERTURBATION) _view.references = createReferenceSet(_view);
+	uint32_t epoch = startFrame(_view);
+	if (!renderFarm.nodes.empty()) submitFarmFrame(_view, _kernelIndex, epoch);
+	else submitTiles(kernelArray[_kernelIndex].function, _view, epoch, _workerCount, vector<bool>(getTileCount(_view), true), 1, false, false, 0);
+}
+
+/* Blocks until the frame started by 'submitBatchFrame' is computed */
+void waitForBatchFrame()
+{
+	if (!renderFarm.nodes.empty()) waitForFarmFrame();
+	else waitForJobs();
+}
+
+/* Colours the iteration counts and escape fractions of a buffer into tightly packed RGB bytes in '_rgb' */
+void colourRgb(const MclIterationBuffer& _buffer, const MclBuffer<float>& _fractions, int _maxIterations, vector<uint8_t>& _rgb)
+{
+	vector<MclPixel> colours((size_t)_buffer.width * _buffer.height);
+	colourPixels(_buffer, _fractions, 0, _buffer.width, 0, _buffer.height, getColouring(_maxIterations, nullptr), colours.data());
+	_rgb.resize(colours.size() * 3);
+	for (size_t i = 0; i < colours.size(); i++) memcpy(&_rgb[3 * i], colours[i].colour, 3);
+}
+
+/* Renders one image to a file. The image is computed in strips of BATCH_STRIP_ROWS rows, so only a few strips are
+held in memory at once however large the image is. While the workers compute a strip, the last one is coloured and written */
+bool renderImage(const MclBatchOptions& _options)
+{
+	MclView image = getBatchView(_options);
+	int tmpLocalKernelIndex = getKernelForView(image);
+	MclImageWriter writer;
+	MclMapWriter map;
+	bool saveMap = isIterationMapPath(_options.output);
+	if (saveMap ? !createIterationMap(map, _options.output, image, kernelArray[tmpLocalKernelIndex].precision) : !openImage(writer, _options.output, _options.width, _options.height)) return false;
+	cout << "Rendering " << _options.width << "x" << _options.height << " pixels to " << _options.output << " [" << kernelArray[tmpLocalKernelIndex].name << ", " << image.maxIterations << " iterations]" << endl;
+
+	timer::time_point start = timer::now();
+	MclIterationBuffer finishedStrip(_options.width, BATCH_STRIP_ROWS);
+	MclBuffer<float> finishedFractions(_options.width, BATCH_STRIP_ROWS);
+	vector<uint8_t> rgb;
+	bool haveFinishedStrip = false, written = true;
+	for (int y = 0; y < _options.height || haveFinishedStrip; y += BATCH_STRIP_ROWS)
+	{
+		if (y < _options.height) submitBatchFrame(getStripView(image, y, std::min(BATCH_STRIP_ROWS, _options.height - y)), tmpLocalKernelIndex, _options.threads);
+		if (haveFinishedStrip)
+		{
+			if (saveMap) written = written && writeIterationMapRows(map, finishedStrip, finishedFractions);
+			else
+			{
+				colourRgb(finishedStrip, finishedFractions, image.maxIterations, rgb);
+				written = written && writeImageRows(writer, rgb.data(), finishedStrip.height);
+			}
+			cout << "\r" << std::min(y, _options.height) * 100ll / _options.height << "%" << std::flush;
+		}
+		waitForBatchFrame();
+		haveFinishedStrip = y < _options.height;
+		if (haveFinishedStrip)
+		{
+			finishedStrip.copyFrom(pixels);
+			finishedFractions.copyFrom(fractionPixels);
+		}
+	}
+	written = (saveMap ? finishIterationMap(map) : closeImage(writer)) && written;
+
+	int time_taken = (int)duration_cast<milliseconds>(timer::now() - start).count();
+	cout << "\r" << time_taken << "ms (" << (double)_options.width * _options.height / 1000.0 / std::max(time_taken, 1) << " Mpixels/s)" << endl;
+	if (!written) cout << "Could not write " << _options.output << "." << endl;
+	return written;
+}
+
+/* Renders a zoom animation along the keyframes to a video stream or image sequence. The frames are pipelined:
+while the workers compute a frame, the last one is coloured and encoded, and throughput is reported in frames/s */
+bool renderAnimation(const MclBatchOptions& _options)
+{
+	vector<MclKeyframe> keyframes;
+	if (!loadKeyframes(_options.keyframes, keyframes)) return false;
+	double duration = keyframes.back().time - keyframes.front().time;
+	int frameCount = _options.frames > 0 ? _options.frames : 1 + (int)lround(duration * _options.fps);
+	MclVideoWriter writer;
+	if (!openVideo(writer, _options.output, _options.width, _options.height, _options.fps)) return false;
+	cout << "Rendering " << frameCount << " frames of " << _options.width << "x" << _options.height << " pixels to " << _options.output << endl;
+
+	timer::time_point start = timer::now();
+	MclIterationBuffer finishedFrame(_options.width, _options.height);
+	MclBuffer<float> finishedFractions(_options.width, _options.height);
+	vector<uint8_t> rgb;
+	int finishedMaxIterations = 0;
+	bool haveFinishedFrame = false, written = true;
+	for (int frame = 0; frame < frameCount || haveFinishedFrame; frame++)
+	{
+		MclView view;
+		if (frame < frameCount)
+		{
+			double time = keyframes.front().time + (frameCount > 1 ? duration * frame / (frameCount - 1) : 0.0);
+			view = getBatchView(getKeyframeOptions(_options, keyframes, time));
+			submitBatchFrame(view, getKernelForView(view), _options.threads);
+		}
+		if (haveFinishedFrame)
+		{
+			colourRgb(finishedFrame, finishedFractions, finishedMaxIterations, rgb);
+			written = written && writeVideoFrame(writer, rgb.data());
+			double seconds = duration_cast<microseconds>(timer::now() - start).count() / 1e6;
+			cout << "\rframe " << writer.framesWritten << "/" << frameCount << " (" << writer.framesWritten / std::max(seconds, 1e-6) << " frames/s)" << std::flush;
+		}
+		waitForBatchFrame();
+		haveFinishedFrame = frame < frameCount;
+		if (haveFinishedFrame)
+		{
+			finishedFrame.copyFrom(pixels);
+			finishedFractions.copyFrom(fractionPixels);
+			finishedMaxIterations = view.maxIterations;
+		}
+	}
+	written = closeVideo(writer) && written;
+
+	double seconds = std::max(duration_cast<microseconds>(timer::now() - start).count() / 1e6, 1e-6);
+	cout << "\r" << frameCount << " frames in " << (int)(seconds * 1000) << "ms (" << frameCount / seconds << " frames/s, " << (double)_options.width * _options.height * frameCount / 1e6 / seconds << " Mpixels/s)" << endl;
+	if (!written) cout << "Could not write " << _options.output << "." << endl;
+	return written;
+}
+
+// views of the benchmark suite: the whole set, the two classic valleys, a minibrot past double precision,
+// and a view inside the main cardioid without interior checks, where every pixel runs to the iteration limit
+const MclBenchView benchViewArray[] =
+{
+	{ "full set", "-0.5", "0", 1.0, 1000, true },
+	{ "seahorse valley", "-0.743643887037151", "0.131825904205330", 2e4, 2000, true },
+	{ "elephant valley", "0.2925", "0.0149", 50.0, 1000, true },
+	{ "deep minibrot", "-1.98999976155807123071060193787858603838383103694879312555112", "0", 3.5e12, 3000, true },
+	{ "cardioid interior", "-0.1", "0", 20.0, 1000, false }
+};
+
+/* Times '_renderFrame' '_repeats' times after a warm-up run, and stores the median and 95th percentile frame time in '_result' */
+template <typename F>
+void timeBenchmark(MclBenchResult& _result, int _repeats, F _renderFrame)
+{
+	_renderFrame();
+	vector<double> times;
+	for (int i = 0; i < _repeats; i++)
+	{
+		timer::time_point start = timer::now();
+		_renderFrame();
+		times.push_back(duration_cast<microseconds>(timer::now() - start).count() / 1000.0);
+	}
+	std::sort(times.begin(), times.end());
+	_result.medianMs = times.size() % 2 ? times[times.size() / 2] : (times[times.size() / 2 - 1] + times[times.size() / 2]) / 2.0;
+	_result.p95Ms = times[(size_t)ceil(0.95 * times.size()) - 1]; // nearest rank
+}
+
+/* Writes the results of the benchmark suite to '_path', as JSON if it ends in .json and as CSV otherwise */
+bool writeBenchmarkReport(const std::string& _path, const MclBatchOptions& _options, const vector<MclBenchResult>& _results)
+{
+	try
+	{
+		std::ofstream file(_path, std::ios::trunc);
+		if (!file)
+		{
+			cout << "Cannot create '" << _path << "'." << endl;
+			return false;
+		}
+		std::string extension = _path.substr(std::min(_path.size(), _path.find_last_of('.')));
+		for (char& c : extension) c = (char)tolower((unsigned char)c);
+		bool json = extension == ".json";
+		const char* cpuNames[] = { "scalar", "AVX2", "AVX-512" };
+		double pixelCount = (double)_options.width * _options.height;
+
+		if (json) file << "{\n\t\"cpu\": \"" << cpuNames[cpuFeature] << "\",\n\t\"hardware_threads\": " << thread::hardware_concurrency()
+			<< ",\n\t\"width\": " << _options.width << ",\n\t\"height\": " << _options.height << ",\n\t\"repeats\": " << _options.repeats << ",\n\t\"results\": [\n";
+		else file << "view,kernel,threads,width,height,max_iterations,repeats,median_ms,p95_ms,mpixels_per_s,giterations_per_s,scaling_efficiency\n";
+		for (size_t i = 0; i < _results.size(); i++)
+		{
+			const MclBenchResult& result = _results[i];
+			double mpixels = pixelCount / 1000.0 / result.medianMs, giterations = result.iterations / 1e6 / result.medianMs;
+			if (json)
+			{
+				file << "\t\t{ \"view\": \"" << result.view << "\", \"kernel\": \"" << result.kernel << "\", \"threads\": " << result.threads
+					<< ", \"max_iterations\": " << result.maxIterations << ", \"median_ms\": " << result.medianMs << ", \"p95_ms\": " << result.p95Ms
+					<< ", \"mpixels_per_s\": " << mpixels << ", \"giterations_per_s\": " << giterations << ", \"scaling_efficiency\": " << result.efficiency
+					<< " }" << (i + 1 < _results.size() ? "," : "") << "\n";
+			}
+			else
+			{
+				file << result.view << "," << result.kernel << "," << result.threads << "," << _options.width << "," << _options.height << "," << result.maxIterations
+					<< "," << _options.repeats << "," << result.medianMs << "," << result.p95Ms << "," << mpixels << "," << giterations << "," << result.efficiency << "\n";
+			}
+		}
+		if (json) file << "\t]\n}\n";
+		return (bool)file;
+	}
+	catch (const exception& e) { cout << "ERROR (writeBenchmarkReport)\n" << e.what() << endl; }
+	return false;
+}
+
+/* Prints one result of the benchmark suite as it comes in */
+void printBenchmarkResult(const MclBenchResult& _result, const MclBatchOptions& _options)
+{
+	cout << _result.view << ", " << _result.kernel;
+	if (_result.threads > 0) cout << ", " << _result.threads << (_result.threads == 1 ? " thread" : " threads");
+	cout << ": " << _result.medianMs << "ms median, " << _result.p95Ms << "ms p95, " << (double)_options.width * _options.height / 1000.0 / _result.medianMs << " Mpixels/s, "
+		<< _result.iterations / 1e6 / _result.medianMs << " Giterations/s";
+	if (_result.threads > 1) cout << ", " << (int)lround(_result.efficiency * 100.0) << "% scaling";
+	cout << endl;
+}
+
+/* Runs the benchmark suite and writes its report. Every view of 'benchViewArray' is rendered by each supported kernel
+precise enough for it, with 1, 2, 4, ... up to '_options.threads' threads, and by the GPU backends in a hidden window.
+The frames are only computed, not coloured. GPU frames are not read back, so they are given the iterations the CPU counted */
+bool runBenchmark(const MclBatchOptions& _options)
+{
+	vector<int> threadCounts;
+	for (int threads = 1; threads < _options.threads; threads *= 2) threadCounts.push_back(threads);
+	threadCounts.push_back(_options.threads);
+
+	// the GPU backends render into a texture, made in a hidden window of their own
+	GLFWwindow* window = nullptr;
+	MclDisplayTexture texture;
+	MclGpuBackend gpuArray[2];
+	bool gpuReady[2] = { false, false };
+	try
+	{
+		if (glfwInit())
+		{
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+			window = glfwCreateWindow(_options.width, _options.height, "Mandelbrot benchmark", NULL, NULL);
+		}
+		if (window)
+		{
+			glfwMakeContextCurrent(window);
+			MclView textureSize;
+			textureSize.width = _options.width;
+			textureSize.height = _options.height;
+			glGenTextures(1, &texture.id);
+			fitDisplayTexture(texture, textureSize);
+			for (int i = 0; i < 2; i++) gpuReady[i] = createGpuBackend(gpuArray[i], BACKEND_GPU_FLOAT + i, texture.id);
+		}
+		else cout << "No OpenGL context, the GPU backends are left out." << endl;
+	}
+	catch (const exception& e) { cout << "ERROR (runBenchmark GPU setup)\n" << e.what() << endl; }
+
+	cout << "Benchmarking " << _options.width << "x" << _options.height << " pixels, " << _options.repeats << " runs each, up to " << _options.threads << " threads" << endl;
+	vector<MclBenchResult> results;
+	for (const MclBenchView& bench : benchViewArray)
+	{
+		// the views of the suite are all of the Mandelbrot set, which the GPU backends compute as well
+		MclBatchOptions settings = _options;
+		settings.fractal = MclFractal();
+		parseBigFixed(bench.centreX, settings.centreX);
+		parseBigFixed(bench.centreY, settings.centreY);
+		settings.zoom = bench.zoom;
+		settings.maxIterations = bench.maxIterations;
+		MclView image = getBatchView(settings);
+		image.interiorChecks = bench.interiorChecks;
+		MclPrecision required = getRequiredPrecision(image);
+
+		MclBenchResult result;
+		result.view = bench.name;
+		result.maxIterations = image.maxIterations;
+		double viewIterations = -1.0;
+		for (int k = 0; k < KERNEL_COUNT; k++)
+		{
+			if (!isKernelSupported(k) || kernelArray[k].precision < required) continue;
+			result.kernel = kernelArray[k].name;
+			double singleThreadMs = 0.0;
+			for (int threads : threadCounts)
+			{
+				resizeWorkerPool(threads);
+				timeBenchmark(result, _options.repeats, [&] { submitBatchFrame(image, k, threads); waitForJobs(); });
+				result.threads = threads;
+				result.iterations = (double)getFrameStats(frameEpoch).iterations;
+				if (threads == 1) singleThreadMs = result.medianMs;
+				result.efficiency = singleThreadMs / (result.medianMs * threads);
+				if (viewIterations < 0.0) viewIterations = result.iterations;
+				printBenchmarkResult(result, _options);
+				results.push_back(result);
+			}
+		}
+
+		// the emulated double shader has about 48 bits, close enough to double for timing it
+		for (int i = 0; i < 2; i++)
+		{
+			if (!gpuReady[i] || required > (i == 0 ? PRECISION_FLOAT : PRECISION_DOUBLE)) continue;
+			result.kernel = getBackendName(BACKEND_GPU_FLOAT + i);
+			result.threads = 0;
+			timeBenchmark(result, _options.repeats, [&] { computeGpuFrame(gpuArray[i], texture, image); });
+			result.iterations = viewIterations;
+			result.efficiency = 1.0;
+			printBenchmarkResult(result, _options);
+			results.push_back(result);
+		}
+	}
+	resizeWorkerPool(_options.threads);
+
+	try
+	{
+		for (MclGpuBackend& gpu : gpuArray) destroyGpuBackend(gpu);
+		if (texture.id) glDeleteTextures(1, &texture.id);
+		if (window) glfwDestroyWindow(window);
+		glfwTerminate();
+	}
+	catch (const exception& e) { cout << "ERROR (runBenchmark GPU cleanup)\n" << e.what() << endl; }
+
+	bool written = writeBenchmarkReport(_options.bench, _options, results);
+	if (written) cout << "Wrote " << results.size() << " results to " << _options.bench << "." << endl;
+	return written;
+}
+
+/* Batch frontend, renders the image or animation given on the command line to a file without opening a window, or runs the benchmark suite */
+int runBatch(int _argc, char** _argv)
+{
+	MclBatchOptions options;
+	if (!parseBatchOptions(_argc, _argv, options))
+	{
+		cout << "Usage: " << _argv[0] << " [--center <re> <im>] [--zoom <magnification>] [--size <width>x<height>]\n"
+			<< "       [--iterations <limit>] [--threads <count>] [--pin] [--palette <Classic|Ocean|Fire|Grey>] [--bands]\n"
+			<< "       [--julia <re> <im> | --burning-ship] [--power <2-" << MAX_POWER << ">]\n"
+			<< "       [--output <file.png|file.tif|file.mcm>] [--farm <host>:<port>[,<host>:<port>...]]\n"
+			<< "   or: " << _argv[0] << " --keyframes <file> [--frames <count>] [--fps <rate>] [--size ...] [--iterations ...] [--threads ...]\n"
+			<< "       [--output <file.y4m|file.rgb|frame%05d.png>] [--farm ...]\n"
+			<< "   or: " << _argv[0] << " --bench <report.csv|report.json> [--repeat <count>] [--size ...] [--threads <most>]\n"
+			<< "   or: " << _argv[0] << " --serve <port> [--threads <count>] [--pin]\n"
+			<< "Each keyframe line holds <seconds> <re> <im> <zoom>. --farm shares the tiles of a render with worker processes\n"
+			<< "started with --serve. --pin pins each thread to a processor of its own. A .mcm output is an iteration map, shown by the interactive viewer with " << _argv[0] << " --open <file.mcm>.\n"
+			<< "Without any options the interactive viewer is started." << endl;
+		return 1;
+	}
+	bool rendered = false;
+	try
+	{
+		threadPinning = options.pin;
+		if (setThreadCount(options.threads))
+		{
+			paletteIndex = options.palette;
+			smoothColouring = options.smooth;
+			if (options.servePort != 0) rendered = runFarmWorker(options.servePort);
+			else if (!options.bench.empty()) rendered = runBenchmark(options);
+			else if (startRenderFarm(options.farm)) rendered = options.keyframes.empty() ? renderImage(options) : renderAnimation(options);
+		}
+	}
+	catch (const exception& e) { cout << "ERROR (runBatch)\n" << e.what() << endl; }
+	stopRenderFarm();
+	shutdownWorkerPool();
+	return rendered ? 0 : 1;
+}
+
+/*** ~ MAIN FUNCTION ~ ***/
+
+/* Interactive frontend, asks for the settings on the console and shows the set in a window, recomputing it whenever
+the view or a setting changes. If '_mapPath' is given, the iteration map in it is shown first, see 'showIterationMap' */
+int runInteractive(const std::string& _mapPath)
+{
+	try
+	{
+		// get # of threads from the user, validate input. 0 uses one per logical processor
+		{
+			printCpuTopology();
+			int localThreadCount = -1;
+			do
+			{
+				cout << "Enter number of threads (0 = " << getAutomaticThreadCount() << "): ";
+				cin >> localThreadCount;
+			} while (!setThreadCount(localThreadCount == 0 ? getAutomaticThreadCount() : localThreadCount));
+		}
+
+		// get the backend from the user, validate input
+		{
+			int localBackend = -1;
+			do
+			{
+				cout << "Enter backend (0 = CPU, 1 = GPU float, 2 = GPU emulated double): ";
+				cin >> localBackend;
+			} while (localBackend < BACKEND_CPU || localBackend > BACKEND_GPU_DOUBLE);
+			backend = localBackend;
+		}
+
+		// display some information
+		cout << "Please wait...\n" << endl;
+		cout << "Left Click - Zoom in.\nRight Click - Reset zoom.\nUp Key - Increase threads by one.\nDown Key - Decrease threads by one.\nK Key - Switch kernel.\nP Key - Toggle perturbation for deep zooms.\nI Key - Toggle interior checks (cardioid, bulb and periodicity).\nR Key - Toggle progressive rendering.\nM Key - Toggle Mariani-Silver subdivision.\nE Key - Toggle anti-aliasing the edges.\nN Key - Toggle pinning threads to processors.\nJ Key - Switch fractal (Mandelbrot, Julia of the point under the cursor, Burning Ship).\nQ Key - Switch the power of z.\nW/A/S/D Keys - Move the view.\nPage Up/Page Down Keys - Double/halve the iteration limit.\nL Key - Toggle raising the iteration limit with the zoom.\nC Key - Toggle filling frames from the tile cache.\nO Key - Go back to the iteration map given with --open.\nG Key - Switch palette.\nF Key - Toggle smooth colouring.\nH Key - Toggle histogram equalisation.\nT Key - Toggle shading tiles by how long they took.\nX Key - Toggle recording a trace of the worker pool.\nZ Key - Toggle prefetching the zoom under the cursor.\nV Key - Toggle vsync.\nHome/End Keys - Double/halve the frame rate cap.\n[/] Keys - Halve/double the render resolution." << endl;
+		cout << "\n\nPERFORMANCE MEASUREMENTS:" << endl;
+
+		// set zoom values to default, and open the tiles kept from earlier sessions and the iteration map
+		resetZoom();
+		openTileStore();
+		if (!_mapPath.empty() && openIterationMap(_mapPath)) showIterationMap();
+
+		// start rendering thread
+		thread renderingThread(render);
+
+		// the last frame computed on the CPU, its tiles are reused when the view is only moved.
+		// If it was finished and every pixel has its orbit in 'orbitPixels', raising the limit continues it
+		MclView previousView;
+		uint32_t previousEpoch = 0;
+		int previousKernelIndex = -1;
+		bool previousResumable = false;
+
+		// mandelbrot calculation loop
+		try
+		{
+			while (!windowClosed)
+			{
+				// take the latest view requested, anything changing from here on makes this frame stale
+				MclView tmpLocalRequest;
+				uint32_t generation = takeRenderRequest(tmpLocalRequest);
+
+				// start timer
+				timer::time_point start = timer::now();
+
+				// queue the tiles for the worker pool, or hand the view to the GPU backend
+				int tmpLocalThreadCount = getThreadCount();
+				int tmpLocalBackend = backend;
+				int tmpLocalReusedTiles = 0;
+				int tmpLocalCachedTiles = 0;
+				int tmpLocalPreviewTime = -1;
+				int tmpLocalResumeFrom = 0;
+				uint32_t tmpLocalEpoch = 0;
+				bool tmpLocalIdle = true;
+				MclView tmpLocalView = getFrameView(tmpLocalRequest, generation);
+				int tmpLocalKernelIndex = getKernelForView(tmpLocalView);
+
+				// filling uniform rectangles relies on the set being connected, which only the Mandelbrot sets are
+				bool tmpLocalSubdivision = subdivision && tmpLocalView.fractal.formula == FORMULA_MANDELBROT;
+				if (tmpLocalBackend != BACKEND_CPU && !isQuadraticMandelbrot(tmpLocalView.fractal))
+				{
+					cout << "The GPU backend only computes the Mandelbrot set, using the CPU instead." << endl;
+					backend = tmpLocalBackend = BACKEND_CPU;
+				}
+				if (tmpLocalBackend != BACKEND_CPU) computeOnGpu(tmpLocalView);
+				else
+				{
+					if (kernelArray[tmpLocalKernelIndex].precision == PRECISION_PERTURBATION) tmpLocalView.references = createReferenceSet(tmpLocalView);
+					bool sameSettings = tmpLocalKernelIndex == previousKernelIndex && tmpLocalView.interiorChecks == previousView.interiorChecks && isSameFractal(tmpLocalView.fractal, previousView.fractal);
+					int dx = 0, dy = 0;
+					if (sameSettings && previousResumable && tmpLocalView.maxIterations > previousView.maxIterations && getPanOffset(previousView, tmpLocalView, dx, dy) && dx == 0 && dy == 0 && isFrameFinished(previousView, previousEpoch)) tmpLocalResumeFrom = previousView.maxIterations;
+					tmpLocalEpoch = startFrame(tmpLocalView);
+					vector<bool> neededTiles(getTileCount(tmpLocalView), true);
+					if (sameSettings && tmpLocalView.maxIterations == previousView.maxIterations) tmpLocalReusedTiles = reuseTiles(previousView, previousEpoch, tmpLocalView, tmpLocalEpoch, neededTiles);
+					takePrefetchedTiles();
+					if (tileCaching && tmpLocalResumeFrom == 0) tmpLocalCachedTiles = fetchCachedTiles(tmpLocalView, tmpLocalKernelIndex, tmpLocalEpoch, neededTiles);
+
+					// one pass per step, each refining the last one. A new view cancels the frame between passes
+					int firstStep = progressiveRendering && !tmpLocalSubdivision && tmpLocalResumeFrom == 0 ? PROGRESSIVE_STEP : 1;
+					for (int step = firstStep; step >= 1 && !isStale(generation); step /= 2)
+					{
+						MclKernel kernel = tmpLocalResumeFrom > 0 ? kernelArray[tmpLocalKernelIndex].resume : kernelArray[tmpLocalKernelIndex].function;
+						submitTiles(kernel, tmpLocalView, tmpLocalEpoch, tmpLocalThreadCount, neededTiles, step, step != firstStep, tmpLocalSubdivision && tmpLocalResumeFrom == 0, tmpLocalResumeFrom);
+
+						// wait for the workers to finish, or only until the view changes. The next frame then starts
+						// right away on the workers which are free, while the others drop what is left of this one
+						tmpLocalIdle = waitForFrame(generation);
+						if (step == firstStep && firstStep > 1) tmpLocalPreviewTime = duration_cast<milliseconds>(timer::now() - start).count();
+					}
+					if (!isStale(generation)) storeFinishedTiles(tmpLocalView, tmpLocalKernelIndex, tmpLocalEpoch, neededTiles);
+
+					// then give the edges of the finished tiles extra samples, which the cache does not keep
+					if (antialiasing && !isStale(generation))
+					{
+						submitAntialiasTiles(kernelArray[tmpLocalKernelIndex].function, tmpLocalView, tmpLocalEpoch, tmpLocalThreadCount);
+						tmpLocalIdle = waitForFrame(generation);
+					}
+					previousView = tmpLocalView;
+					previousEpoch = tmpLocalEpoch;
+					previousKernelIndex = tmpLocalKernelIndex;
+
+					// tiles from the cache have no orbits to continue
+					previousResumable = (tmpLocalResumeFrom > 0 || (!tmpLocalSubdivision && tmpLocalReusedTiles == 0 && tmpLocalCachedTiles == 0)) && kernelArray[tmpLocalKernelIndex].resume != nullptr;
+
+					// the trace gets every frame while it is recorded, cancelled ones too
+					if (traceRecording) collectTrace(start, timer::now(), tmpLocalIdle);
+					else
+					{
+						traceEvents.clear();
+						if (tmpLocalIdle) for (MclWorkerStats& stats : workerStatsArray) stats.trace.clear();
+					}
+				}
+
+				// end timer and
+				timer::time_point end = timer::now();
+				int time_taken = duration_cast<milliseconds>(end - start).count();
+				if (!isStale(generation) && tmpLocalBackend != BACKEND_CPU)
+				{
+					cout << time_taken << "ms [" << getBackendName(tmpLocalBackend) << "]" << endl;
+					waitForRenderRequest(generation); // pause and wait
+				}
+				else if (!isStale(generation))
+				{
+					// display computation time, and how long each thread was busy
+					MclWorkerStats tmpLocalStats = getFrameStats(tmpLocalEpoch);
+					long long tmpLocalComputedPixels = tmpLocalStats.escapedPixels + tmpLocalStats.limitPixels + tmpLocalStats.interiorPixels;
+					cout << time_taken << "ms [" << kernelArray[tmpLocalKernelIndex].name << ", " << tmpLocalView.maxIterations << " iterations";
+					if (tmpLocalView.scale != 1.0) cout << ", " << tmpLocalView.width << "x" << tmpLocalView.height << " pixels";
+					if (tmpLocalView.references) cout << ", " << 1 + tmpLocalView.references->secondary.size() << " reference orbits";
+					if (tmpLocalReusedTiles > 0) cout << ", " << tmpLocalReusedTiles << " tiles reused";
+					if (tmpLocalCachedTiles > 0) cout << ", " << tmpLocalCachedTiles << " tiles from cache";
+					if (tmpLocalPreviewTime >= 0) cout << ", preview after " << tmpLocalPreviewTime << "ms";
+					if (tmpLocalResumeFrom > 0) cout << ", " << tmpLocalComputedPixels << " pixels resumed from " << tmpLocalResumeFrom << " iterations";
+					else if (tmpLocalSubdivision) cout << ", " << tmpLocalComputedPixels * 100 / (tmpLocalView.width * tmpLocalView.height) << "% of pixels computed";
+					cout << "] (busy:";
+					for (int i = 0; i < tmpLocalThreadCount; i++) cout << " " << (workerStatsArray[i].epoch == tmpLocalEpoch ? workerStatsArray[i].busyMicroseconds / 1000 : 0) << "ms";
+					cout << ")" << endl;
+					printFrameStats(tmpLocalView, tmpLocalEpoch, tmpLocalStats, time_taken, tmpLocalThreadCount);
+					prefetchWhileIdle(generation, tmpLocalThreadCount); // pause and wait, computing the zoom under the cursor
+				}
+			}
+		}
+		catch (const exception& e) { cout << "ERROR (mandelbrot calculation loop)\n" << e.what() << endl; }
+
+		shutdownWorkerPool();
+		renderingThread.join();
+		closeTileStore();
+		closeIterationMap();
+
+		cout << "\n\nDone.\n\n" << endl;
+		system("pause");
+	}
+	catch (const exception& e) { cout << "ERROR (runInteractive)\n" << e.what() << endl; }
+
+	return 0;
+}
+
+/* Renders the image given on the command line to a file, or starts the interactive viewer without arguments
+or with --open <file.mcm> */
+int main(int argc, char** argv)
+{
+	try
+	{
+		// find out which kernels this CPU can run, and where the workers can run
+		cpuFeature = detectCpuFeature();
+		cpuTopology = detectCpuTopology();
+	}
+	catch (const exception& e) { cout << "ERROR (main)\n" << e.what() << endl; }
+
+	if (argc == 3 && std::string(argv[1]) == "--open") return runInteractive(argv[2]);
+	if (argc > 1) return runBatch(argc, argv);
+	return runInteractive("");
 }
\ No newline at end of file